@@ -7,6 +7,7 @@
 
 #include "bms.h"
 #include "config.h"
+#include "eventlog.h"
 
 bool bms::ConditionDaemon::get() const
 {
@@ -104,7 +105,12 @@ void bms::BMS::update()
 	if(enabled && conditiondaemon.get()) {
 		disabled_error_id = conditiondaemon.get_signal_cause()->cd_id;
 		set_enabled(false);
+		//Record the trip (and the sensor values that caused it) so it survives a power cycle
+		//If EEPROM is busy the record is queued and written by update(). push only fails if an earlier trip is still queued, which can't happen without re-arming.
+		eventlog::events.push(disabled_error_id);
 	}
+	//Finishes writing a trip record that had to wait for EEPROM
+	eventlog::events.update();
 	btimer_relayLeft.update();
 	btimer_relayRight.update();
 }
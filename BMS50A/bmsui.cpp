@@ -112,9 +112,67 @@ ui::statdisplay::StatDisplay * ui::statdisplay::get_statdisplay_conditionID(bms:
 	return nullptr;
 }
 
+namespace {
+	//Value in tenths, as printed by "%2.1f"
+	int16_t round_tenths(float const value)
+	{
+		return static_cast<int16_t>(value * 10.0f + (value < 0.0f ? -0.5f : 0.5f));
+	}
+	//Prints tenths like "%2.1f" (so the string only depends on tenths, which makes it the cache key)
+	void print_tenths(char str[], uint8_t const len, int16_t const tenths)
+	{
+		libmodule::userio::format_fixed(str, len, tenths, 1);
+	}
+	//Value in hundredths (for Printer::print_full)
+	int16_t round_hundredths(float const value)
+	{
+		return static_cast<int16_t>(value * 100.0f + (value < 0.0f ? -0.5f : 0.5f));
+	}
+	//Prints value / 10^sig10 followed by unit (e.g. "12.4A")
+	void print_fixed_unit(char str[], uint8_t const len, int16_t const value, uint8_t const sig10, char const unit)
+	{
+		if(len < 2) return;
+		libmodule::userio::format_fixed(str, len - 1, value, sig10);
+		size_t const end = strlen(str);
+		str[end] = unit;
+		str[end + 1] = '\0';
+	}
+}
+
+void ui::printer::Printer::print_full(char str[], uint8_t const len /*= libmodule::userio::ScrollingText::str_len*/) const
+{
+	print(str, len);
+}
+
+bool ui::printer::PrintCache::get(int16_t const key, char str[], uint8_t const len) const
+{
+	if(pm_len == 0 || len != pm_len || key != pm_key) return false;
+	memcpy(str, pm_str, len);
+	return true;
+}
+
+void ui::printer::PrintCache::set(int16_t const key, char const str[], uint8_t const len)
+{
+	//Strings longer than the cache aren't cached
+	if(len > sizeof pm_str) {
+		pm_len = 0;
+		return;
+	}
+	pm_key = key;
+	pm_len = len;
+	memcpy(pm_str, str, len);
+}
+
 void ui::printer::CellVoltage::print(char str[], uint8_t const len /*= 4*/) const 
 {
-	snprintf(str, len, "%2.1f", static_cast<double>(s->get()));
+	int16_t const tenths = round_tenths(s->get());
+	if(pm_cache.get(tenths, str, len)) return;
+	print_tenths(str, len, tenths);
+	pm_cache.set(tenths, str, len);
+}
+void ui::printer::CellVoltage::print_full(char str[], uint8_t const len /*= libmodule::userio::ScrollingText::str_len*/) const
+{
+	print_fixed_unit(str, len, round_hundredths(s->get()), 2, 'V');
 }
 ui::printer::CellVoltage::CellVoltage(bms::Sensor_t const *s) : s(s) {}
 
@@ -125,7 +183,18 @@ void ui::printer::AverageCellVoltage::print(char str[], uint8_t const len /*= 4*
 	for(uint8_t i = 0; i < 6; i++) {
 		sum += s[i]->get();
 	}
-	snprintf(str, len, "%2.1f", static_cast<double>(sum / 6));
+	int16_t const tenths = round_tenths(sum / 6);
+	if(pm_cache.get(tenths, str, len)) return;
+	print_tenths(str, len, tenths);
+	pm_cache.set(tenths, str, len);
+}
+void ui::printer::AverageCellVoltage::print_full(char str[], uint8_t const len /*= libmodule::userio::ScrollingText::str_len*/) const
+{
+	float sum = 0.0f;
+	for(uint8_t i = 0; i < 6; i++) {
+		sum += s[i]->get();
+	}
+	print_fixed_unit(str, len, round_hundredths(sum / 6), 2, 'V');
 }
 ui::printer::AverageCellVoltage::AverageCellVoltage(bms::Sensor_t *s[6]) : s(s) {}
 
@@ -135,7 +204,18 @@ void ui::printer::BatteryVoltage::print(char str[], uint8_t const len /*= 4*/) c
 	for(uint8_t i = 0; i < 6; i++) {
 		sum += s[i]->get();
 	}
-	snprintf(str, len, "%02d", static_cast<int>(sum));
+	int16_t const volts = static_cast<int16_t>(sum);
+	if(pm_cache.get(volts, str, len)) return;
+	snprintf(str, len, "%02d", volts);
+	pm_cache.set(volts, str, len);
+}
+void ui::printer::BatteryVoltage::print_full(char str[], uint8_t const len /*= libmodule::userio::ScrollingText::str_len*/) const
+{
+	float sum = 0.0f;
+	for(uint8_t i = 0; i < 6; i++) {
+		sum += s[i]->get();
+	}
+	print_fixed_unit(str, len, round_tenths(sum), 1, 'V');
 }
 ui::printer::BatteryVoltage::BatteryVoltage(bms::Sensor_t *s[6]) : s(s) {}
 
@@ -151,17 +231,35 @@ ui::printer::BatteryPresent::BatteryPresent(bms::DigiSensor_t const *s) : s(s) {
 void ui::printer::Temperature::print(char str[], uint8_t const len /*= 4*/) const 
 {
 	float val = s->get();
-	//Should read 187.5356 when disconnected
-	if(val >= 180.0f) strncpy(str, "--", len);
-	else snprintf(str, len, "%2.1f", static_cast<double>(val));
+	//Should read 187.5356 when disconnected (cached as key_disconnected)
+	constexpr int16_t key_disconnected = 0x7fff;
+	int16_t const tenths = val >= 180.0f ? key_disconnected : round_tenths(val);
+	if(pm_cache.get(tenths, str, len)) return;
+	if(tenths == key_disconnected) strncpy(str, "--", len);
+	else print_tenths(str, len, tenths);
 	//If there is a decimal point on the right, don't show it
 	if(str[2] == '.') str[2] = '\0';
+	pm_cache.set(tenths, str, len);
+}
+void ui::printer::Temperature::print_full(char str[], uint8_t const len /*= libmodule::userio::ScrollingText::str_len*/) const
+{
+	float const val = s->get();
+	//Should read 187.5356 when disconnected
+	if(val >= 180.0f) strncpy(str, "--", len);
+	else print_fixed_unit(str, len, round_tenths(val), 1, 'C');
 }
 ui::printer::Temperature::Temperature(bms::Sensor_t const *s) : s(s) {}
 
 void ui::printer::Current::print(char str[], uint8_t const len /*= 4*/) const 
 {
-	snprintf(str, len, "%2.1f", static_cast<double>(libmodule::utility::tmax<float>(0.0f, s->get())));
+	int16_t const tenths = round_tenths(libmodule::utility::tmax<float>(0.0f, s->get()));
+	if(pm_cache.get(tenths, str, len)) return;
+	print_tenths(str, len, tenths);
+	pm_cache.set(tenths, str, len);
+}
+void ui::printer::Current::print_full(char str[], uint8_t const len /*= libmodule::userio::ScrollingText::str_len*/) const
+{
+	print_fixed_unit(str, len, round_tenths(libmodule::utility::tmax<float>(0.0f, s->get())), 1, 'A');
 }
 ui::printer::Current::Current(bms::sensor::CurrentOptimised *s) : s(s) {}
 
@@ -215,27 +313,29 @@ void ui::Armed::ui_update()
 		ui_common->dp_right_blinker.run_pattern(pattern_dp_armed);
 		//Setup and start timers
 		timer_displaytimeout = ticks_displaytimeout;
-		stopwatch_cycletimeout.reset();
 		timer_displaytimeout.start();
-		stopwatch_cycletimeout.start();
-		//Make sure first statdisplay is showing label
-		statdisplay::all[0]->on_highlight(true);
+		scroller.set_display(&ui_common->segs);
+		//The right decimal point is used by the armed pattern
+		scroller.set_dp_flags(libmodule::userio::IC_LTD_2601G_11::OVERWRITE_LEFT);
 	}
 	//If the BMS has an error, the BMS will flip the relay. Armed finishes there.
 	if(bms_ptr->get_error_signal()) {
 		result_finishedBecauseOfError = true;
 		ui_common->dp_right_blinker.set_state(false);
+		ui_common->segs.set_brightness(0xff);
 		ui_finish();
 	}
 	//If the centre button is pressed, disable the BMS (which flips relay) and finish
 	if(ui_common->dpad.centre.get()) {
 		bms_ptr->set_enabled(false);
 		ui_common->dp_right_blinker.set_state(false);
+		ui_common->segs.set_brightness(0xff);
 		ui_finish();
 	}
 	//If the left button is pressed, leave the Armed screen
 	else if(ui_common->dpad.left.get()) {
 		ui_common->dp_right_blinker.set_state(false);
+		ui_common->segs.set_brightness(0xff);
 		ui_finish();
 	}
 
@@ -247,45 +347,54 @@ void ui::Armed::ui_update()
 		timer_displaytimeout.start();
 	}
 
-	//If the display is on, cycle through values
-	if(display_on) {
-		//If display timeout has been reached, turn off display
-		if(timer_displaytimeout) {
-			display_on = false;
-			ui_common->segs.clear();
-		}
-		else {
-			auto current_statdisplay = statdisplay::all[statdisplay_all_pos];
-			//When it is time to stop showing the label, switch to the statistic (number)
-			if(stopwatch_cycletimeout.ticks >= ticks_labeltimeout && current_statdisplay->showing_name) {
-				//Calling on_click should swap them
-				current_statdisplay->on_click();
-			}
-			//If it is time for a new statistic
-			if(stopwatch_cycletimeout.ticks >= ticks_cycletimeout) {
-				//Move onto next one
-				if(++statdisplay_all_pos >= statdisplay::all_len) statdisplay_all_pos = 0;
-				current_statdisplay = statdisplay::all[statdisplay_all_pos];
-				//Make sure next one shows label
-				current_statdisplay->on_highlight(true);
-				//Reset the cycle timeout
-				stopwatch_cycletimeout = 0;
-			}
-			//on_highlight will call update(), which updates/prints to the statdisplay
-			else current_statdisplay->update();
-			//Write to display
-			ui_common->segs.write_characters(current_statdisplay->name, sizeof current_statdisplay->name, libmodule::userio::IC_LTD_2601G_11::OVERWRITE_LEFT);
-		}
-	}
-	//If not, check for buttons being pressed that will turn on the display
-	else if(wakeup_button_pressed) {
-		display_on = true;
-		//Go back to the first statdisplay (also make sure name is showing)
-		statdisplay::all[0]->on_highlight(true);
+	//If it is dimmed or off, check for buttons being pressed that will brighten the display
+	if(display_state != DisplayState::On && wakeup_button_pressed) {
+		display_state = DisplayState::On;
+		ui_common->segs.set_brightness(0xff);
+		//Go back to the first statdisplay
 		statdisplay_all_pos = 0;
-		//Reset the cycle timer
-		stopwatch_cycletimeout.ticks = 0;
+		scroller.clear();
+	}
+	//If display timeout has been reached, dim the display (values keep cycling)
+	else if(display_state == DisplayState::On && timer_displaytimeout) {
+		display_state = DisplayState::Dimmed;
+		ui_common->segs.set_brightness(brightness_dim);
+		timer_displaytimeout = ticks_dimtimeout;
+		timer_displaytimeout.start();
+	}
+	//If it has been dimmed for long enough, clear the display (the armed pattern stays on the right decimal point)
+	else if(display_state == DisplayState::Dimmed && timer_displaytimeout) {
+		display_state = DisplayState::Off;
+		scroller.clear();
+		ui_common->segs.clear();
+	}
+	//Nothing to show, so don't spend time formatting values
+	if(display_state == DisplayState::Off)
+		return;
+
+	//Once a statistic has been shown, queue the next one (name, then value)
+	if(scroller.finished()) {
+		auto current_statdisplay = statdisplay::all[statdisplay_all_pos];
+		if(++statdisplay_all_pos >= statdisplay::all_len) statdisplay_all_pos = 0;
+		//stat_name has no '\0'
+		char str[libmodule::userio::ScrollingText::str_len] = {};
+		memcpy(str, current_statdisplay->stat_name, sizeof current_statdisplay->stat_name);
+		scroller.push(str, ticks_labeltimeout);
+		current_statdisplay->stat_printer->print_full(str, sizeof str);
+		scroller.push(str, ticks_cycletimeout - ticks_labeltimeout);
+		value_printer = current_statdisplay->stat_printer;
+		timer_valuerefresh = ticks_valuerefresh;
+		timer_valuerefresh.start();
+	}
+	//Once the name has been shown, keep the value up to date
+	else if(scroller.count() == 1 && timer_valuerefresh) {
+		char str[libmodule::userio::ScrollingText::str_len] = {};
+		value_printer->print_full(str, sizeof str);
+		scroller.set_front(str);
+		timer_valuerefresh = ticks_valuerefresh;
+		timer_valuerefresh.start();
 	}
+	scroller.update();
 }
 
 libmodule::userio::Blinker::Pattern ui::Armed::pattern_dp_armed = {
@@ -426,7 +535,8 @@ void ui::TriggerDetails::ui_update()
 {
 	if(runinit) {
 		runinit = false;
-		timer_animation.finished = true;
+		char str_errorname[libmodule::userio::ScrollingText::str_len] = "--";
+		char str_errorvalue[libmodule::userio::ScrollingText::str_len] = "--";
 		//Determine statdisplay to copy the parameters from
 		statdisplay::StatDisplay *statdisplay_copy = nullptr;
 		//Check for a condition that caused a disable first
@@ -437,10 +547,15 @@ void ui::TriggerDetails::ui_update()
 		//If a statdisplay was found for that error ID, copy in the name and the error text
 		if(statdisplay_copy != nullptr) {
 			//Copy name of statistic into str_errorname
-			memcpy(str_errorname, statdisplay_copy->stat_name, sizeof str_errorname);
+			memcpy(str_errorname, statdisplay_copy->stat_name, sizeof statdisplay_copy->stat_name);
 			//Print the error into str_errorvalue
-			statdisplay_copy->stat_printer->print(str_errorvalue);
+			statdisplay_copy->stat_printer->print_full(str_errorvalue, sizeof str_errorvalue);
 		}
+		scroller.set_display(&ui_common->segs);
+		scroller.set_repeat(true);
+		scroller.push("Er", config::default_ui_triggerdetails_ticks_display_errortext);
+		scroller.push(str_errorname, config::default_ui_triggerdetails_ticks_display_nametext);
+		scroller.push(str_errorvalue, config::default_ui_triggerdetails_ticks_display_valuetext);
 	}
 	buttontimer_dpad.update();
 	if(buttontimer_dpad.pressedFor(config::default_ui_triggerdetails_ticks_exittimeout)) {
@@ -452,27 +567,7 @@ void ui::TriggerDetails::ui_update()
 		ui_common->dpad.centre.reset();
 		ui_finish();
 	}
-	if(timer_animation.finished) {
-		//Consider a more generic way of changing animation states. Probably not worth it for only 3 different ones though.
-		switch (displaystate) {
-		case DisplayState::ErrorText:
-			ui_common->segs.write_characters("Er", 2, libmodule::userio::IC_LTD_2601G_11::OVERWRITE_LEFT | libmodule::userio::IC_LTD_2601G_11::OVERWRITE_RIGHT);
-			timer_animation = config::default_ui_triggerdetails_ticks_display_errortext;
-			displaystate = DisplayState::NameText;
-			break;
-		case DisplayState::NameText:
-			ui_common->segs.write_characters(str_errorname);
-			timer_animation = config::default_ui_triggerdetails_ticks_display_nametext;
-			displaystate = DisplayState::ValueText;
-			break;
-		case DisplayState::ValueText:
-			ui_common->segs.write_characters(str_errorvalue, sizeof str_errorvalue);
-			timer_animation = config::default_ui_triggerdetails_ticks_display_valuetext;
-			displaystate = DisplayState::ErrorText;
-			break;
-		}
-		timer_animation.start();
-	}
+	scroller.update();
 }
 
 bool ui::TriggerDetails::get() const 
@@ -499,25 +594,13 @@ void ui::TriggerSettingsEdit<bool>::on_valueedit_finished(Screen *const onoff_in
 	}
 }
 
-void ui::MainMenu::ui_update()
-{
-	if(runinit) {
-		runinit = false;
-		auto menu_list = new libmodule::ui::segdpad::List;
-		//3 menu items
-		//	- Armed
-		//	- Stats
-		//	- Settings
-		strcpy(item_armed.name, "Ar");
-		strcpy(item_stats.name, "SA");
-		strcpy(item_settings.name, "St");
-		menu_list->m_items.resize(3);
-		menu_list->m_items[0] = &item_armed;
-		menu_list->m_items[1] = &item_stats;
-		menu_list->m_items[2] = &item_settings;
-		ui_spawn(menu_list);
-	}
-}
+ui::MainMenu::Item const ui::MainMenu::pgm_items[] PROGMEM = {
+	{"Ar", &MainMenu::on_armed_clicked, nullptr, nullptr},
+	{"SA", &MainMenu::on_stats_clicked, nullptr, nullptr},
+	{"St", &MainMenu::on_settings_clicked, nullptr, nullptr},
+};
+
+void ui::MainMenu::menu_on_back() {}
 
 libmodule::ui::Screen<libmodule::ui::segdpad::Common> * ui::MainMenu::on_armed_clicked()
 {
@@ -547,41 +630,19 @@ libmodule::ui::Screen<libmodule::ui::segdpad::Common> * ui::MainMenu::on_setting
 	return new TriggerSettingsList();
 }
 
-ui::MainMenu::MainMenu() : item_armed(this, &MainMenu::on_armed_clicked), item_stats(this, &MainMenu::on_stats_clicked), item_settings(this, &MainMenu::on_settings_clicked) {}
+ui::MainMenu::MainMenu() : Menu(pgm_items) {}
 
 
 
-ui::TriggerSettingsList::TriggerSettingsList() :
- item_undervoltage(this, &TriggerSettingsList::on_undervoltage_clicked),
- item_overvoltage(this, &TriggerSettingsList::on_overvoltage_clicked),
- item_overcurrent(this, &TriggerSettingsList::on_overcurrent_clicked),
- item_overtemperature(this, &TriggerSettingsList::on_overtemperature_clicked),
- item_batterypresent(this, &TriggerSettingsList::on_batterypresent_clicked) {}
+ui::TriggerSettingsList::Item const ui::TriggerSettingsList::pgm_items[] PROGMEM = {
+	{"Lc", &TriggerSettingsList::on_undervoltage_clicked, nullptr, nullptr},
+	{"Hc", &TriggerSettingsList::on_overvoltage_clicked, nullptr, nullptr},
+	{"Cu", &TriggerSettingsList::on_overcurrent_clicked, nullptr, nullptr},
+	{"tp", &TriggerSettingsList::on_overtemperature_clicked, nullptr, nullptr},
+	{"bp", &TriggerSettingsList::on_batterypresent_clicked, nullptr, nullptr},
+};
 
-void ui::TriggerSettingsList::ui_update()
-{
-	if(runinit) {
-		runinit = false;
-		strcpy(item_undervoltage.name, "Lc");
-		strcpy(item_overvoltage.name, "Hc");
-		strcpy(item_overcurrent.name, "Cu");
-		strcpy(item_overtemperature.name, "tp");
-		strcpy(item_batterypresent.name, "bp");
-		auto itemlist = new libmodule::ui::segdpad::List;
-		itemlist->m_items.resize(5);
-		itemlist->m_items[0] = &item_undervoltage;
-		itemlist->m_items[1] = &item_overvoltage;
-		itemlist->m_items[2] = &item_overcurrent;
-		itemlist->m_items[3] = &item_overtemperature;
-		itemlist->m_items[4] = &item_batterypresent;
-		ui_spawn(itemlist);
-	}
-}
-
-void ui::TriggerSettingsList::ui_on_childComplete()
-{
-	ui_finish();
-}
+ui::TriggerSettingsList::TriggerSettingsList() : Menu(pgm_items) {}
 
 //C++ way would be anonymous namespace, but this works too
 static constexpr float convfn_edit_to_cellvoltage(uint16_t const p) {
@@ -669,29 +730,13 @@ auto ui::TriggerSettingsList::on_batterypresent_clicked()->Screen *
 	return new TriggerSettingsEdit<bool>(config::settings.trigger_battery_present, config::default_trigger_battery_present);
 }
 
-ui::SettingsMenu::SettingsMenu() :
- item_triggersettings(this, &SettingsMenu::on_triggersettings_clicked),
- //item_displaysettings(this, &SettingsMenu::on_displaysettings_clicked),
- item_resetall(this, &SettingsMenu::on_resetall_clicked, &SettingsMenu::on_resetall_finished) {}
-
-void ui::SettingsMenu::ui_update()
-{
-	strcpy(item_triggersettings.name, "tr");
-	//strcpy(item_displaysettings.name, "dS");
-	strcpy(item_resetall.name, "dE");
-	auto itemlist = new libmodule::ui::segdpad::List;
-	itemlist->m_items.resize(2);
-	itemlist->m_items[0] = &item_triggersettings;
-	//itemlist->m_items[1] = &item_displaysettings;
-	itemlist->m_items[1] = &item_resetall;
-	ui_spawn(itemlist);
-}
+ui::SettingsMenu::Item const ui::SettingsMenu::pgm_items[] PROGMEM = {
+	{"tr", &SettingsMenu::on_triggersettings_clicked, nullptr, nullptr},
+	//{"dS", &SettingsMenu::on_displaysettings_clicked, nullptr, nullptr},
+	{"dE", &SettingsMenu::on_resetall_clicked, &SettingsMenu::on_resetall_finished, nullptr},
+};
 
-void ui::SettingsMenu::ui_on_childComplete()
-{
-	//List finish, this finishes
-	ui_finish();
-}
+ui::SettingsMenu::SettingsMenu() : Menu(pgm_items) {}
 
 /*
 auto ui::SettingsMenu::on_displaysettings_clicked()->Screen *
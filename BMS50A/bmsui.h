@@ -22,24 +22,46 @@ namespace ui {
 	namespace printer {
 		struct Printer {
 			virtual void print(char str[], uint8_t const len = 4) const = 0;
+			//Prints with more precision and the unit, for showing with a ScrollingText (by default the same as print)
+			virtual void print_full(char str[], uint8_t const len = libmodule::userio::ScrollingText::str_len) const;
+		};
+		//The last value a Printer printed (as what is shown, e.g. tenths) and the string it printed, so an unchanged value isn't formatted again
+		struct PrintCache {
+			//If key and len are the same as the last set(), copies the cached string to str and returns true
+			bool get(int16_t const key, char str[], uint8_t const len) const;
+			void set(int16_t const key, char const str[], uint8_t const len);
+		private:
+			int16_t pm_key = 0;
+			//0 if nothing is cached
+			uint8_t pm_len = 0;
+			char pm_str[4];
 		};
 		struct CellVoltage : public Printer {
 			void print(char str[], uint8_t const len = 4) const override;
+			void print_full(char str[], uint8_t const len = libmodule::userio::ScrollingText::str_len) const override;
 			CellVoltage(bms::Sensor_t const *s);
 			bms::Sensor_t const *s;
+		private:
+			mutable PrintCache pm_cache;
 		};
 		struct AverageCellVoltage : public Printer {
 			void print(char str[], uint8_t const len = 4) const override;
+			void print_full(char str[], uint8_t const len = libmodule::userio::ScrollingText::str_len) const override;
 			//For some reason GCC doesn't like const here
 			AverageCellVoltage(bms::Sensor_t *s[6]);
 			//Or here
 			bms::Sensor_t **s;
+		private:
+			mutable PrintCache pm_cache;
 		};
 		struct BatteryVoltage : public Printer {
 			void print(char str[], uint8_t const len = 4) const override;
+			void print_full(char str[], uint8_t const len = libmodule::userio::ScrollingText::str_len) const override;
 			//Takes an array of 6 sensors to perform a sum
 			BatteryVoltage(bms::Sensor_t *s[6]);
 			bms::Sensor_t **s;
+		private:
+			mutable PrintCache pm_cache;
 		};
 		struct BatteryPresent : public Printer {
 			void print(char str[], uint8_t const len = 4) const override;
@@ -48,13 +70,19 @@ namespace ui {
 		};
 		struct Temperature : public Printer {
 			void print(char str[], uint8_t const len = 4) const override;
+			void print_full(char str[], uint8_t const len = libmodule::userio::ScrollingText::str_len) const override;
 			Temperature(bms::Sensor_t const *s);
 			bms::Sensor_t const *s;
+		private:
+			mutable PrintCache pm_cache;
 		};
 		struct Current : public Printer {
 			void print(char str[], uint8_t const len = 4) const override;
+			void print_full(char str[], uint8_t const len = libmodule::userio::ScrollingText::str_len) const override;
 			Current(bms::sensor::CurrentOptimised *s);
 			bms::sensor::CurrentOptimised *s;
+		private:
+			mutable PrintCache pm_cache;
 		};
 
 		extern CellVoltage        *cellvoltage[6];
@@ -101,10 +129,10 @@ namespace ui {
 
 	/* For when the BMS is 'armed'/in its running state (technically it should always be armed unless interrupted at startup or triggered).
 	 * Upon startup will arm the relay if it wasn't already -> enable the BMS
-	 * Will cycle through statistics to be displayed, showing the name of the statistic and then the value. Display will turn off after timeout.
+	 * Will cycle through statistics to be displayed, showing the name of the statistic and then the value. Display will dim after timeout, and then clear (which stops the cycling) after another timeout.
 	 * Navigation:
-	 *	up: skip/cycle current statistic up. If display is off, turn on display.
-	 *	down: skip/cycle current statistic down. If display is off, turn on display.
+	 *	up: skip/cycle current statistic up. If display is dimmed or off, brighten display.
+	 *	down: skip/cycle current statistic down. If display is dimmed or off, brighten display.
 	 *	left: ui_finish
 	 *	right: wake up display
 	 *	centre:	trigger relay, ui_finish
@@ -119,17 +147,30 @@ namespace ui {
 		void ui_update() override;
 		//Will be true if Armed finishes because of a BMS condition (but not if the centre button was pressed)
 		bool runinit = true;
-		bool display_on = true;
-		//The amount time of inactivity before the display turns off
+		enum class DisplayState : uint8_t {
+			On,
+			Dimmed,
+			Off,
+		} display_state = DisplayState::On;
+		//The amount time of inactivity before the display is dimmed
 		uint32_t ticks_displaytimeout = config::default_ui_armed_ticks_displaytimeout;
+		//The amount of time the display is dimmed for before it is cleared
+		uint32_t ticks_dimtimeout = config::default_ui_armed_ticks_dimtimeout;
+		uint8_t brightness_dim = config::default_ui_armed_brightness_dim;
 		//The ticks_labeltimeout + ticks for value
 		uint16_t ticks_cycletimeout = config::default_ui_armed_ticks_cycletimeout;
 		//The amount of time to show the statistic name for
 		uint16_t ticks_labeltimeout = config::default_ui_armed_ticks_labeltimeout;
-		//Use uint32_ts for the display timeout (since 65535 is only 65 seconds)
+		//Use uint32_ts for the display timeout (since 65535 is only 65 seconds), also used for the dim timeout
 		libmodule::time::Timer<1000, uint32_t> timer_displaytimeout;
-		libmodule::Stopwatch1k stopwatch_cycletimeout;
+		//Shows the name then the value of each statistic
+		libmodule::userio::ScrollingText scroller;
+		//The next statdisplay to show
 		uint8_t statdisplay_all_pos = 0;
+		//Printer of the value in the scroller (printed again every ticks_valuerefresh while it is shown)
+		printer::Printer const *value_printer = nullptr;
+		uint16_t ticks_valuerefresh = config::default_ui_armed_ticks_valuerefresh;
+		libmodule::Timer1k timer_valuerefresh;
 	};
 
 	/* Counts down from a number (probably 5) in seconds.
@@ -170,34 +211,29 @@ namespace ui {
 		bool get() const override;
 		TriggerDetails();
 	private:
-		enum class DisplayState {
-			ErrorText,
-			NameText,
-			ValueText,
-		} displaystate = DisplayState::ErrorText;
 		bool runinit = true;
 		libmodule::userio::ButtonTimer1k buttontimer_dpad;
-		libmodule::Timer1k timer_animation;
-		char str_errorname[2] = {'-', '-'};
-		char str_errorvalue[4] = "--";
+		//Repeats "Er", the statistic name and the statistic value
+		libmodule::userio::ScrollingText scroller;
 	};
 
 	/* UI interface to allow the user to edit a config::TriggerConfig<value_t> object.
 	 * There is a specialization for bool, which is why there is a Common object and two inherited objects.
 	 */
 	template <typename value_t>
-	class TriggerSettingsEdit_Common : public libmodule::ui::Screen<libmodule::ui::segdpad::Common> {
+	class TriggerSettingsEdit_Common : public libmodule::ui::segdpad::Menu<TriggerSettingsEdit_Common<value_t>> {
+		using Menu = libmodule::ui::segdpad::Menu<TriggerSettingsEdit_Common>;
 	public:
 		TriggerSettingsEdit_Common(config::TriggerSettings<value_t> &trigger, config::TriggerSettings<value_t> const &trigger_default);
 	protected:
+		using Screen = libmodule::ui::Screen<libmodule::ui::segdpad::Common>;
 		config::TriggerSettings<value_t> &triggersettings;
 		//virtual so that a different method can be used for subclass value_t specialization
 		virtual Screen *on_valueedit_clicked() = 0;
 		virtual void on_valueedit_finished(Screen *const) = 0;
 	private:
-		void ui_update() override;
 		//Saves settings and finishes
-		void ui_on_childComplete() override;
+		void menu_on_back() override;
 		
 		//Spawns NumberInputDecimal to edit timeout
 		Screen *on_timeedit_clicked();
@@ -212,14 +248,10 @@ namespace ui {
 		void on_resettodefault_finished(Screen *const yn_input);
 
 		//Sets the decimal point to match the enabled state
-		void on_enableedit_highlight(bool const firstcycle);
+		void on_enableedit_highlight(char name[4], bool const firstcycle);
 		
-		bool runinit = true;
 		config::TriggerSettings<value_t> const &triggersettings_default;
-		libmodule::ui::segdpad::List::Item_MemFnCallback<TriggerSettingsEdit_Common> item_valueedit;
-		libmodule::ui::segdpad::List::Item_MemFnCallback<TriggerSettingsEdit_Common> item_timeedit;
-		libmodule::ui::segdpad::List::Item_MemFnCallback<TriggerSettingsEdit_Common> item_enablededit;
-		libmodule::ui::segdpad::List::Item_MemFnCallback<TriggerSettingsEdit_Common> item_resettodefault;
+		static typename Menu::Item const pgm_items[4];
 	};
 
 	//Consider changing uint16_t to a type template parameter.
@@ -272,14 +304,10 @@ namespace ui {
 	};
 
 
-	class TriggerSettingsList : public libmodule::ui::Screen<libmodule::ui::segdpad::Common> {
+	class TriggerSettingsList : public libmodule::ui::segdpad::Menu<TriggerSettingsList> {
 	public:
 		TriggerSettingsList();
 	private:
-		void ui_update() override;
-		//Finishes
-		void ui_on_childComplete() override;
-
 		//Each spawns a TriggerSettingsEdit
 		Screen *on_undervoltage_clicked();
 		Screen *on_overvoltage_clicked();
@@ -287,23 +315,13 @@ namespace ui {
 		Screen *on_overtemperature_clicked();
 		Screen *on_batterypresent_clicked();
 
-		//This probably isn't actually needed, since ui_update should only be calld once. TODO: Check.
-		bool runinit = true;
-		using Item_MemFnCallback = libmodule::ui::segdpad::List::Item_MemFnCallback<TriggerSettingsList>;
-		Item_MemFnCallback item_undervoltage;
-		Item_MemFnCallback item_overvoltage;
-		Item_MemFnCallback item_overcurrent;
-		Item_MemFnCallback item_overtemperature;
-		Item_MemFnCallback item_batterypresent;
+		static Item const pgm_items[5];
 	};
 
-	class SettingsMenu : public libmodule::ui::Screen<libmodule::ui::segdpad::Common> {
+	class SettingsMenu : public libmodule::ui::segdpad::Menu<SettingsMenu> {
 	public:
 		SettingsMenu();
 	private:
-		void ui_update() override;
-		void ui_on_childComplete() override;
-
 		//Spawns TriggerSettingsList
 		Screen *on_triggersettings_clicked();
 		//Spawns
@@ -314,20 +332,18 @@ namespace ui {
 		//Resets settings if user confirmed
 		void on_resetall_finished(Screen *const selector);
 
-		using Item_MemFnCallback = libmodule::ui::segdpad::List::Item_MemFnCallback<SettingsMenu>;
-		Item_MemFnCallback item_triggersettings;
-		//Item_MemFnCallback item_displaysettings;
-		Item_MemFnCallback item_resetall;
+		static Item const pgm_items[2];
 	};
 
-	/* Main UI menu. Itself spawns a List of menu items, but houses the callbacks for the events in the menu.
+	/* Main UI menu. Houses the callbacks for the events in the menu.
 	 * If the 'Arm' option is selected, will finish.
 	 */
-	class MainMenu : public libmodule::ui::Screen<libmodule::ui::segdpad::Common> {
+	class MainMenu : public libmodule::ui::segdpad::Menu<MainMenu> {
 	public:
 		MainMenu();
 	private:
-		void ui_update() override;
+		//Does nothing (the menu is only left by arming)
+		void menu_on_back() override;
 		//Will check the BMS status and run the Armed blinker if it is enabled
 		void update_armed_blinker();
 
@@ -335,11 +351,7 @@ namespace ui {
 		Screen *on_stats_clicked();
 		Screen *on_settings_clicked();
 
-
-		bool runinit = true;
-		libmodule::ui::segdpad::List::Item_MemFnCallback<MainMenu> item_armed;
-		libmodule::ui::segdpad::List::Item_MemFnCallback<MainMenu> item_stats;
-		libmodule::ui::segdpad::List::Item_MemFnCallback<MainMenu> item_settings;
+		static Item const pgm_items[3];
 	};
 
 	/* Top-level Screen. On startup, spawns StartupDelay.
@@ -372,43 +384,23 @@ namespace ui {
 
 
 template <typename value_t>
-ui::TriggerSettingsEdit_Common<value_t>::TriggerSettingsEdit_Common(config::TriggerSettings<value_t> &trigger, config::TriggerSettings<value_t> const &trigger_default)
- : triggersettings(trigger), triggersettings_default(trigger_default),
- item_valueedit(this, &TriggerSettingsEdit_Common::on_valueedit_clicked, &TriggerSettingsEdit_Common::on_valueedit_finished),
- item_timeedit(this, &TriggerSettingsEdit_Common::on_timeedit_clicked, &TriggerSettingsEdit_Common::on_timeedit_finished),
- item_enablededit(this, &TriggerSettingsEdit_Common::on_enablededit_clicked, nullptr, &TriggerSettingsEdit_Common::on_enableedit_highlight),
- item_resettodefault(this, &TriggerSettingsEdit_Common::on_resettodefault_clicked, &TriggerSettingsEdit_Common::on_resettodefault_finished) {}
+typename ui::TriggerSettingsEdit_Common<value_t>::Menu::Item const ui::TriggerSettingsEdit_Common<value_t>::pgm_items[] PROGMEM = {
+	{"VA", &TriggerSettingsEdit_Common::on_valueedit_clicked, &TriggerSettingsEdit_Common::on_valueedit_finished, nullptr},
+	{"ti", &TriggerSettingsEdit_Common::on_timeedit_clicked, &TriggerSettingsEdit_Common::on_timeedit_finished, nullptr},
+	{"En", &TriggerSettingsEdit_Common::on_enablededit_clicked, nullptr, &TriggerSettingsEdit_Common::on_enableedit_highlight},
+	{"dE", &TriggerSettingsEdit_Common::on_resettodefault_clicked, &TriggerSettingsEdit_Common::on_resettodefault_finished, nullptr},
+};
 
 template <typename value_t>
-void ui::TriggerSettingsEdit_Common<value_t>::ui_update()
-{
-	if(runinit) {
-		runinit = false;
-		//Clear the name for enablededit to allow null terminators for both 2 character and 3 character strings
-		memset(item_enablededit.name, '\0', sizeof item_enablededit.name);
-		//Copy in the rest of the strings
-		strcpy(item_valueedit.name, "VA");
-		strcpy(item_timeedit.name, "ti");
-		strcpy(item_enablededit.name, "En");
-		strcpy(item_resettodefault.name, "dE");
-		//Add all the callback items to the list and spawn the list
-		auto settings_list = new libmodule::ui::segdpad::List;
-		settings_list->m_items.resize(4);
-		settings_list->m_items[0] = &item_valueedit;
-		settings_list->m_items[1] = &item_timeedit;
-		settings_list->m_items[2] = &item_enablededit;
-		settings_list->m_items[3] = &item_resettodefault;
-		//Note to self for future: ui_spawn needs to be in ui_update since ui_common has not transferred in the	constructor, and therefore the child will never receive it.
-		ui_spawn(settings_list);
-	}
-}
+ui::TriggerSettingsEdit_Common<value_t>::TriggerSettingsEdit_Common(config::TriggerSettings<value_t> &trigger, config::TriggerSettings<value_t> const &trigger_default)
+ : Menu(pgm_items), triggersettings(trigger), triggersettings_default(trigger_default) {}
 
 template <typename value_t>
-void ui::TriggerSettingsEdit_Common<value_t>::ui_on_childComplete()
+void ui::TriggerSettingsEdit_Common<value_t>::menu_on_back()
 {
-	//When the user exits the list, save the settings to EEPROM and finish
+	//When the user exits the menu, save the settings to EEPROM and finish
 	config::settings.save();
-	ui_finish();
+	this->ui_finish();
 }
 
 template <typename value_t>
@@ -453,7 +445,7 @@ void ui::TriggerSettingsEdit_Common<value_t>::on_timeedit_finished(Screen *const
 	if(static_cast<NumberInputDecimal *>(decinput)->m_confirmed) {
 		triggersettings.ticks_timeout = static_cast<NumberInputDecimal *>(decinput)->m_value * 10;
 		//Run a confirm animation if no other animations are running
-		ui_common->dp_right_blinker.run_pattern_ifSolid(libmodule::ui::segdpad::pattern::rubberband);
+		this->ui_common->dp_right_blinker.run_pattern_ifSolid(libmodule::ui::segdpad::pattern::rubberband);
 	}
 }
 
@@ -465,15 +457,15 @@ void ui::TriggerSettingsEdit_Common<value_t>::on_resettodefault_finished(Screen
 	if(static_cast<Selector *>(yn_input)->m_confirmed && static_cast<Selector *>(yn_input)->m_result == 1) {
 		triggersettings = triggersettings_default;
 		//Run a confirm animation if the user reset and no other animations are running
-		ui_common->dp_right_blinker.run_pattern_ifSolid(libmodule::ui::segdpad::pattern::rubberband);
+		this->ui_common->dp_right_blinker.run_pattern_ifSolid(libmodule::ui::segdpad::pattern::rubberband);
 	}
 }
 
 template <typename value_t>
-void ui::TriggerSettingsEdit_Common<value_t>::on_enableedit_highlight(bool const firstcycle)
+void ui::TriggerSettingsEdit_Common<value_t>::on_enableedit_highlight(char name[4], bool const firstcycle)
 {
 	//Turn the decimal point on if enabled
-	item_enablededit.name[2] = triggersettings.enabled ? '.' : '\0';
+	name[2] = triggersettings.enabled ? '.' : '\0';
 	//ui_common->dp_right_blinker.set_state(triggersettings.enabled);
 }
 
@@ -8,42 +8,201 @@
 
 #include "config.h"
 
+#include <stddef.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+#include <util/crc16.h>
 #include <generalhardware.h>
 
 config::Settings config::settings;
 
+namespace {
+	using Field = config::Settings::Field;
+	using FieldLayout = config::Settings::FieldLayout;
+	struct Layout {
+		FieldLayout const *fields;
+		uint8_t count;
+	};
+
+	//Offsets are from the start of the EEPROM image (so version 0 starts with the old write_indicator byte)
+	FieldLayout const layout_v0[] PROGMEM = {
+		{Field::TriggerCellMinVoltage, 1, 7},
+		{Field::TriggerCellMaxVoltage, 8, 7},
+		{Field::TriggerMaxCurrent, 15, 7},
+		{Field::TriggerMaxTemperature, 22, 7},
+		{Field::TriggerBatteryPresent, 29, 4},
+		{Field::UiArmedTicksDisplayTimeout, 33, 4},
+		{Field::UiArmedTicksCycleTimeout, 37, 2},
+		{Field::UiArmedTicksLabelTimeout, 39, 2},
+	};
+
+	//The current layout
+#define CONFIG_FIELDLAYOUT(field, member) {Field::field, offsetof(config::Settings, member), sizeof(config::Settings::member)}
+	FieldLayout const layout_v1[] PROGMEM = {
+		CONFIG_FIELDLAYOUT(TriggerCellMinVoltage, trigger_cell_min_voltage),
+		CONFIG_FIELDLAYOUT(TriggerCellMaxVoltage, trigger_cell_max_voltage),
+		CONFIG_FIELDLAYOUT(TriggerMaxCurrent, trigger_max_current),
+		CONFIG_FIELDLAYOUT(TriggerMaxTemperature, trigger_max_temperature),
+		CONFIG_FIELDLAYOUT(TriggerBatteryPresent, trigger_battery_present),
+		CONFIG_FIELDLAYOUT(UiArmedTicksDisplayTimeout, ui_armed_ticks_displaytimeout),
+		CONFIG_FIELDLAYOUT(UiArmedTicksCycleTimeout, ui_armed_ticks_cycletimeout),
+		CONFIG_FIELDLAYOUT(UiArmedTicksLabelTimeout, ui_armed_ticks_labeltimeout),
+	};
+#undef CONFIG_FIELDLAYOUT
+
+	//Indexed by layout version
+	Layout const layouts[] = {
+		{layout_v0, sizeof layout_v0 / sizeof *layout_v0},
+		{layout_v1, sizeof layout_v1 / sizeof *layout_v1},
+	};
+	static_assert(sizeof layouts / sizeof *layouts == config::Settings::layout_version + 1, "Each layout version needs a layout");
+
+	//Number of bytes after the header that are saved
+	constexpr uint8_t settings_len = offsetof(config::Settings, buffer_this) - sizeof(config::Settings::Header);
+	//Keeping the image in one page means it is written with a single erase-write
+	static_assert(sizeof(config::Settings::Header) + settings_len <= EEPROM_PAGE_SIZE, "Settings must fit in one EEPROM page");
+}
+
 //This is handy to keep in mind: https://stackoverflow.com/questions/2008398/is-it-possible-to-print-out-the-size-of-a-c-class-at-compile-time/2008577
 //And so is this: file:///C:/Users/teddy/Documents/Resources/cppreference/reference/en/cpp/language/data_members.html
 /**
- Writes \c this casted as `void *` to EEPROM offest 0x00 using libmicavr::EEPManager::write_buffer(). [Here](https://en.cppreference.com/w/cpp/language/data_members) is a handy section to read for why the save is done this way (Settings is a \em StandardLayoutType).
+ Writes the header and settings (everything from #header up to #buffer_this) to EEPROM offset #eeprom_offset_settings using libmicavr::EEPManager::write_buffer(), and then again to #eeprom_offset_settings_fallback. [Here](https://en.cppreference.com/w/cpp/language/data_members) is a handy section to read for why the save is done this way (Settings is a \em StandardLayoutType).
+ \n The fallback copy is queued after the first, so if power is lost part way through writing one copy, the other is still valid.
+ \n EEPManager only writes the bytes that differ from what is already in EEPROM, so editing a single setting only rewrites the few bytes of that setting (and no page write is made if nothing changed).
+ \n The EEPManager queue is shared with the event log, so it may be full. Any copy that can't be queued is queued later by update().
  \note \c sizeof(float) is 4 bytes.
  */
 void config::Settings::save()
 {
-	buffer_this.pm_ptr = reinterpret_cast<uint8_t *>(this);
-	buffer_this.pm_len = sizeof *this;
+	header.write_indicator = write_indicator;
+	header.version = layout_version;
+	header.len = settings_len;
+	header.crc = calculate_crc(reinterpret_cast<uint8_t const *>(&header));
+	buffer_this.pm_ptr = reinterpret_cast<uint8_t *>(&header);
+	buffer_this.pm_len = sizeof header + settings_len;
 	buffer_this.pm_pos = 0;
-	libmicavr::EEPManager::write_buffer(buffer_this, 0);
+	//Since the image is within one page, the first copy is loaded into the page buffer straight away (if nothing else is being written)
+	copies_unqueued = 0x03;
+	queue_copies();
+}
+
+void config::Settings::update()
+{
+	if(copies_unqueued) queue_copies();
+}
+
+void config::Settings::queue_copies()
+{
+	//The fallback is only queued after the first copy, so that one copy is always valid
+	if((copies_unqueued & 0x01) && libmicavr::EEPManager::write_buffer(buffer_this, eeprom_offset_settings))
+		copies_unqueued &= ~0x01;
+	if(copies_unqueued == 0x02 && libmicavr::EEPManager::write_buffer(buffer_this, eeprom_offset_settings_fallback))
+		copies_unqueued = 0;
 }
 
 
 /**
- If the byte at EEPROM address 0x00 is not equal to #write_indicator, then it is assumed that a Settings object has never been saved to EEPROM. In that case, all members are set to their default values.
- \n In a \em StandardLayoutType, we can \c reinterpret_cast \c this to the first non-static non-bitfield data member. Since #write_indicator is the first non-static data member, it will be the first byte written, and also the first byte loaded.
- \sa save()
+ Only the first copy is checked at startup (a CRC of less than a page), unless it is invalid. If it is invalid the fallback copy is loaded, and the first copy is rewritten from it.
+ \n If the copy loaded had an older layout, both copies are rewritten with the current layout (save() is only called once either way).
+ \n If neither copy is valid but either still has a header, the settings are corrupt and the defaults are used.
+ \n Otherwise, if the first byte in EEPROM is #write_indicator, the settings were written before the header existed (layout version 0) and are migrated. Version 0 never wrote the fallback copy, and its second byte is the low byte of a float (0 for the default thresholds), so it is not normally mistaken for a header.
+ \n Otherwise it is assumed that a Settings object has never been saved to EEPROM. In that case, all members are set to their default values.
+ \sa save(), load_copy()
  */
 void config::Settings::load()
 {
-	//Check to see whether EEPROM stores settings or not
+	bool migrated = false;
+	if(load_copy(eeprom_offset_settings, migrated)) {
+		//Write the upgraded settings back
+		if(migrated) save();
+		return;
+	}
+	//First copy might have been half written
+	if(load_copy(eeprom_offset_settings_fallback, migrated)) {
+		save();
+		return;
+	}
+	//If not, this expression will either: Cause copy-elision (ideal), cause a trivial move assignment (less idea - this just copies). Either way the class will return to the defaults.
+	*this = Settings();
+	//Both copies failed their CRC, so don't migrate them as version 0
+	if(header_present(eeprom_offset_settings) || header_present(eeprom_offset_settings_fallback)) return;
+	//Check to see whether EEPROM stores settings from before the header was added
 	uint8_t eep_write_indicator;
 	libmodule::utility::Buffer buffer(&eep_write_indicator, sizeof eep_write_indicator);
-	libmicavr::EEPManager::read_buffer(buffer, 0, sizeof eep_write_indicator);
-	//If settings are present in EEPROM, read them into this
+	libmicavr::EEPManager::read_buffer(buffer, eeprom_offset_settings, sizeof eep_write_indicator);
 	if(eep_write_indicator == write_indicator) {
-		buffer.pm_ptr = reinterpret_cast<decltype(buffer.pm_ptr)>(this);
-		buffer.pm_len = sizeof *this;
-		libmicavr::EEPManager::read_buffer(buffer, 0, sizeof *this);
+		migrate(0, eeprom_offset_settings);
+		save();
 	}
-	//If not, this expression will either: Cause copy-elision (ideal), cause a trivial move assignment (less idea - this just copies). Either way the class will return to the defaults.
-	else *this = Settings();
+}
+
+/**
+ If the copy has the current layout, it is read straight into \c this. If it has an older layout, members are set to their defaults and then each field that is in both layouts is copied over (see migrate()).
+ \n Nothing is written back, the caller saves if \a migrated is set.
+ */
+bool config::Settings::load_copy(uint8_t const eeprom_offset, bool &migrated)
+{
+	//Check the header makes sense before using len
+	if(!header_present(eeprom_offset)) return false;
+	Header eep_header;
+	libmodule::utility::Buffer buffer(&eep_header, sizeof eep_header);
+	libmicavr::EEPManager::read_buffer(buffer, eeprom_offset, sizeof eep_header);
+	//EEPROM is memory mapped, so the CRC can be calculated without copying the image
+	if(eep_header.crc != calculate_crc(reinterpret_cast<uint8_t const *>(EEPROM_START + eeprom_offset))) return false;
+
+	if(eep_header.version == layout_version && eep_header.len == settings_len) {
+		buffer.pm_ptr = reinterpret_cast<uint8_t *>(&header);
+		buffer.pm_len = sizeof header + settings_len;
+		libmicavr::EEPManager::read_buffer(buffer, eeprom_offset, sizeof header + settings_len);
+	}
+	else {
+		*this = Settings();
+		migrate(eep_header.version, eeprom_offset);
+		migrated = true;
+	}
+	return true;
+}
+
+bool config::Settings::header_present(uint8_t const eeprom_offset)
+{
+	Header eep_header;
+	libmodule::utility::Buffer buffer(&eep_header, sizeof eep_header);
+	libmicavr::EEPManager::read_buffer(buffer, eeprom_offset, sizeof eep_header);
+	return eep_header.write_indicator == write_indicator && eep_header.version != 0 && eep_header.version <= layout_version
+		&& sizeof eep_header + eep_header.len <= EEPROM_PAGE_SIZE;
+}
+
+/**
+ Fields are matched by Field, and only copied if the size has not changed. Any field not found keeps its current (default) value.
+ */
+void config::Settings::migrate(uint8_t const version, uint8_t const eeprom_offset)
+{
+	Layout const &current = layouts[layout_version];
+	Layout const &previous = layouts[version];
+	for(uint8_t i = 0; i < current.count; i++) {
+		FieldLayout to;
+		memcpy_P(&to, current.fields + i, sizeof to);
+		for(uint8_t j = 0; j < previous.count; j++) {
+			FieldLayout from;
+			memcpy_P(&from, previous.fields + j, sizeof from);
+			if(from.field != to.field || from.size != to.size) continue;
+			libmodule::utility::Buffer buffer(reinterpret_cast<uint8_t *>(this) + to.offset, to.size);
+			libmicavr::EEPManager::read_buffer(buffer, eeprom_offset + from.offset, from.size);
+			break;
+		}
+	}
+}
+
+uint16_t config::Settings::calculate_crc(uint8_t const *const image)
+{
+	//CRC covers the header up to the crc member, then the settings
+	uint8_t len = reinterpret_cast<Header const *>(image)->len;
+	uint16_t crc = 0xffff;
+	for(uint8_t i = 0; i < offsetof(Header, crc); i++) {
+		crc = _crc_ccitt_update(crc, image[i]);
+	}
+	for(uint8_t i = 0; i < len; i++) {
+		crc = _crc_ccitt_update(crc, image[sizeof(Header) + i]);
+	}
+	return crc;
 }
@@ -9,6 +9,7 @@
 #pragma once
 
 #include <inttypes.h>
+#include <avr/io.h>
 #include <libmodule/utility.h>
 
 /** \brief The number on the BMS PCB.
@@ -82,12 +83,29 @@ namespace config {
 	constexpr uint16_t default_ui_armed_ticks_labeltimeout = 500;
 	//Should cycle through all displays once
 	constexpr uint32_t default_ui_armed_ticks_displaytimeout = default_ui_armed_ticks_cycletimeout * (6 + 5);
+	//Brightness after the display timeout (1 is the dimmest that is still on, see extrahardware::SegDisplay)
+	constexpr uint8_t default_ui_armed_brightness_dim = 1;
+	//Time spent dimmed before the display is cleared (and the statistics stop cycling), once more through all displays
+	constexpr uint32_t default_ui_armed_ticks_dimtimeout = default_ui_armed_ticks_displaytimeout;
+	//How often the value being shown is printed again (so that the frames in between do no formatting)
+	constexpr uint16_t default_ui_armed_ticks_valuerefresh = 250;
 
 	//ui::TriggerDetails parameters
 	constexpr uint16_t default_ui_triggerdetails_ticks_exittimeout = 1000;
 	constexpr uint16_t default_ui_triggerdetails_ticks_display_errortext = 250;
 	constexpr uint16_t default_ui_triggerdetails_ticks_display_nametext = 500;
 	constexpr uint16_t default_ui_triggerdetails_ticks_display_valuetext = 750;
+
+	///\name EEPROM Layout
+	///@{
+	///Settings are written to the lower half of EEPROM (see Settings::save()).
+	constexpr uint8_t eeprom_offset_settings = 0;
+	///A second copy of the settings is kept in the next page, in case the first is corrupted.
+	constexpr uint8_t eeprom_offset_settings_fallback = EEPROM_PAGE_SIZE;
+	///The event log uses the upper half of EEPROM (see eventlog::EventLog).
+	constexpr uint8_t eeprom_offset_eventlog = EEPROM_PAGE_SIZE * 2;
+	constexpr uint8_t eeprom_size_eventlog = EEPROM_SIZE - eeprom_offset_eventlog;
+	///@}
 }
 
 //Could and probably should split these into multiple anonymous structs
@@ -99,15 +117,53 @@ namespace config {
 	struct Settings {
 		///Writes settings to EEPROM (this was const, but needs to write to buffer_this).
 		void save();
+		///Queues any copy that save() could not queue yet. Call regularly.
+		void update();
 		///Loads settings from EEPROM.
 		void load();
 
-		/** \brief Used to determine whether a Settings object has previously been written to EEPROM.
+		/** \brief Written to EEPROM before the settings.
+		 \details The EEPROM image is the header followed by #len bytes of settings. #crc covers the rest of the header and the settings.
+		 */
+		struct Header {
+			///Used to determine whether a Settings object has previously been written to EEPROM.
+			uint8_t write_indicator;
+			///The layout version the settings were written with.
+			uint8_t version;
+			///Number of bytes of settings after the header.
+			uint8_t len;
+			uint16_t crc;
+		};
+
+		///Identifies a field across layout versions, so that it can be found when migrating.
+		enum class Field : uint8_t {
+			TriggerCellMinVoltage,
+			TriggerCellMaxVoltage,
+			TriggerMaxCurrent,
+			TriggerMaxTemperature,
+			TriggerBatteryPresent,
+			UiArmedTicksDisplayTimeout,
+			UiArmedTicksCycleTimeout,
+			UiArmedTicksLabelTimeout,
+		};
+		///Position of a field in the EEPROM image of a particular layout version.
+		struct FieldLayout {
+			Field field;
+			uint8_t offset;
+			uint8_t size;
+		};
+
+		/** \brief Value of Header::write_indicator.
 		 \details 0x5e was chosen since it is similar to <b>SE</b>MA.
-		 \note This cannot be \c const since it will delete the default move-assignment operator (used in load()), and writing a custom one would be needlessly verbose.
-		 \sa load()
 		 */
-		uint8_t write_indicator = 0x5e;
+		static constexpr uint8_t write_indicator = 0x5e;
+		/** \brief Current layout version. Increment this (and add a layout to config.cpp) whenever the fields below change.
+		 \details Version 0 is the layout from before the header existed (just #write_indicator followed by the fields).
+		 */
+		static constexpr uint8_t layout_version = 1;
+
+		///Must be the first member (the EEPROM image starts here).
+		Header header;
 
 		//Note: sizeof(float) == 4
 		
@@ -127,8 +183,21 @@ namespace config {
 		uint16_t ui_armed_ticks_labeltimeout = default_ui_armed_ticks_labeltimeout;
 		///@}
 
-		//Used as a buffer for EEPManager::write_buffer
+		//Used as a buffer for EEPManager::write_buffer (not part of the EEPROM image)
 		libmodule::utility::Buffer buffer_this;
+		//Copies that still need to be queued with EEPManager, bit 0 is the first copy and bit 1 the fallback (not part of the EEPROM image)
+		uint8_t copies_unqueued = 0;
+	private:
+		///Loads the copy at \a eeprom_offset if it is valid (migrating it if it is an older layout, in which case \a migrated is set). Returns \c false if not valid.
+		bool load_copy(uint8_t const eeprom_offset, bool &migrated);
+		///Queues each copy in #copies_unqueued with EEPManager, leaving the ones that don't fit in the queue.
+		void queue_copies();
+		///Returns \c true if there is a plausible Header (any version after 0) at \a eeprom_offset, whether or not the CRC is correct.
+		static bool header_present(uint8_t const eeprom_offset);
+		///Copies every field in the \a version layout at \a eeprom_offset that is also in the current layout into this.
+		void migrate(uint8_t const version, uint8_t const eeprom_offset);
+		///Returns the CRC of the image starting at \a image (can be an EEPROM address since it is memory mapped).
+		static uint16_t calculate_crc(uint8_t const *const image);
 	};
 	//Global settings struct
 	extern Settings settings;
@@ -0,0 +1,142 @@
+//Created: 19/10/2019 10:13:05 AM
+
+/** \file
+ \brief Source file for eventlog.h.
+ \date Created 2019-10-19
+ \author Teddy.Hut
+ */
+
+#include "eventlog.h"
+
+#include <stddef.h>
+#include <util/atomic.h>
+#include <util/crc16.h>
+#include <generalhardware.h>
+
+#include "sensors.h"
+
+eventlog::EventLog eventlog::events;
+
+uint8_t eventlog::Record::calculate_crc() const
+{
+	uint8_t result = 0;
+	auto bytes = reinterpret_cast<uint8_t const *>(this);
+	for(uint8_t i = 0; i < offsetof(Record, crc); i++) {
+		result = _crc8_ccitt_update(result, bytes[i]);
+	}
+	return result;
+}
+
+bool eventlog::Record::valid() const
+{
+	//Erased EEPROM reads as 0xff, so also reject that sequence number
+	return sequence != 0xffff && crc == calculate_crc();
+}
+
+/**
+ Every slot is read once. The newest record is the valid record with the highest sequence number (compared using a signed difference so that wrapping around 0xffff is fine).
+ */
+void eventlog::EventLog::load()
+{
+	pm_count = 0;
+	pm_head = 0;
+	pm_sequence = 0;
+	Record record;
+	libmodule::utility::Buffer buffer(&record, sizeof record);
+	for(uint8_t i = 0; i < record_count; i++) {
+		libmicavr::EEPManager::read_buffer(buffer, eeprom_offset(i), sizeof record);
+		if(!record.valid()) continue;
+		//Next record goes after the newest one
+		if(pm_count == 0 || static_cast<int16_t>(record.sequence - pm_sequence) >= 0) {
+			pm_sequence = next_sequence(record.sequence);
+			pm_head = (i + 1) % record_count;
+		}
+		pm_count++;
+	}
+	pm_uptime.reset();
+	pm_uptime.start();
+}
+
+bool eventlog::EventLog::push(bms::ConditionID const id)
+{
+	//Only one record can wait for a write
+	if(pm_pending) return false;
+	//Fill record with a snapshot of this cycle's sensor values
+	pm_pendingrecord.timestamp = uptime();
+	pm_pendingrecord.condition = static_cast<uint8_t>(id);
+	for(uint8_t i = 0; i < 6; i++) {
+		pm_pendingrecord.cellvoltage[i] = bms::snc::cellvoltage[i]->get() * 1000;
+	}
+	pm_pendingrecord.current = bms::snc::current_optimised->get() * 100;
+	pm_pendingrecord.temperature = bms::snc::temperature->get() * 10;
+	pm_pending = true;
+	write_pending();
+	return true;
+}
+
+void eventlog::EventLog::update()
+{
+	if(pm_pending) write_pending();
+}
+
+void eventlog::EventLog::write_pending()
+{
+	//pm_record is still being read by EEPManager
+	if(pm_writing) return;
+	pm_record = pm_pendingrecord;
+	pm_record.sequence = pm_sequence;
+	pm_record.crc = pm_record.calculate_crc();
+
+	pm_buffer.pm_ptr = reinterpret_cast<uint8_t *>(&pm_record);
+	pm_buffer.pm_len = sizeof pm_record;
+	pm_buffer.pm_pos = 0;
+	//EEPManager queue is full, try again next update
+	if(!libmicavr::EEPManager::write_buffer(pm_buffer, eeprom_offset(pm_head), this)) return;
+	pm_writing = true;
+	pm_pending = false;
+
+	pm_sequence = next_sequence(pm_sequence);
+	pm_head = (pm_head + 1) % record_count;
+	if(pm_count < record_count) pm_count++;
+}
+
+uint8_t eventlog::EventLog::count() const
+{
+	return pm_count;
+}
+
+bool eventlog::EventLog::get(uint8_t const index, Record &record) const
+{
+	if(index >= pm_count) return false;
+	//Step backwards from the head (add record_count to stay positive)
+	uint8_t slot = (pm_head + record_count - 1 - index) % record_count;
+	libmodule::utility::Buffer buffer(&record, sizeof record);
+	libmicavr::EEPManager::read_buffer(buffer, eeprom_offset(slot), sizeof record);
+	return record.valid();
+}
+
+uint32_t eventlog::EventLog::uptime() const
+{
+	//32 bit value is modified by the timer interrupt
+	uint32_t result;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		result = pm_uptime.ticks;
+	}
+	return result;
+}
+
+void eventlog::EventLog::eeprom_writeCallback(libmodule::utility::Buffer const &)
+{
+	pm_writing = false;
+}
+
+uint8_t eventlog::EventLog::eeprom_offset(uint8_t const slot)
+{
+	return config::eeprom_offset_eventlog + slot * sizeof(Record);
+}
+
+uint16_t eventlog::EventLog::next_sequence(uint16_t const sequence)
+{
+	uint16_t const next = sequence + 1;
+	return next == 0xffff ? 0 : next;
+}
@@ -0,0 +1,93 @@
+//Created: 19/10/2019 10:12:41 AM
+
+/** \file
+ \brief Persistent trip/event log stored in EEPROM.
+ \date Created 2019-10-19
+ \author Teddy.Hut
+ */
+
+#pragma once
+
+#include <inttypes.h>
+#include <libmodule/utility.h>
+#include <libmodule/timer.h>
+#include <generalhardware.h>
+
+#include "bms.h"
+#include "config.h"
+
+///Primary namespace for eventlog.h.
+namespace eventlog {
+	/** \brief A single event as stored in EEPROM.
+	 \details Sensor values are stored as fixed point integers instead of floats to keep the record small (more records fit in EEPROM that way).
+	 */
+	struct Record {
+		///Incremented for every record written. Used at boot to find the most recent record.
+		uint16_t sequence;
+		///Milliseconds since power on when the event occurred.
+		uint32_t timestamp;
+		///The bms::ConditionID that caused the event.
+		uint8_t condition;
+		///Cell voltages in mV.
+		uint16_t cellvoltage[6];
+		///Current in units of 10mA.
+		int16_t current;
+		///Temperature in units of 0.1 degrees celsius.
+		int16_t temperature;
+		///CRC8 of all of the above. A record that fails the check (erased or half written) is ignored.
+		uint8_t crc;
+
+		///Returns the CRC8 of the record (excluding #crc).
+		uint8_t calculate_crc() const;
+		///Returns \c true if #crc matches the record contents.
+		bool valid() const;
+	};
+
+	///Number of records that fit in the EEPROM reserved for the log.
+	constexpr uint8_t record_count = config::eeprom_size_eventlog / sizeof(Record);
+
+	/** \brief Ring buffer of Record objects in EEPROM.
+	 \details Records are written one after the other around the reserved EEPROM area, so each byte is only erased once every #record_count events (this is the wear leveling).
+	 \n No head pointer is stored in EEPROM (it would be rewritten every event and wear out first). Instead load() finds the record with the highest Record::sequence.
+	 \author Teddy.Hut
+	 */
+	class EventLog : public libmicavr::EEPManager::Callbacks {
+	public:
+		///Finds the newest record in EEPROM and starts the uptime stopwatch. Call once at startup.
+		void load();
+		///Queues a record for \a id, taking a snapshot of the current sensor values. Returns \c false if another record is still waiting to be written.
+		bool push(bms::ConditionID const id);
+		///Writes a queued record once the previous write has finished. Call regularly.
+		void update();
+		///Returns the number of valid records in the log.
+		uint8_t count() const;
+		///Reads the record \a index places before the newest into \a record (0 is the newest). Returns \c false if there is no such record.
+		bool get(uint8_t const index, Record &record) const;
+		///Returns milliseconds since load() was called.
+		uint32_t uptime() const;
+	private:
+		//Clears pm_writing
+		void eeprom_writeCallback(libmodule::utility::Buffer const &buffer) override;
+		static uint8_t eeprom_offset(uint8_t const slot);
+		//Sequence number after sequence, skipping 0xffff (Record::valid() rejects it)
+		static uint16_t next_sequence(uint16_t const sequence);
+		//Starts writing pm_pending if EEPManager is free
+		void write_pending();
+
+		///Slot the next record will be written to.
+		uint8_t pm_head = 0;
+		uint8_t pm_count = 0;
+		uint16_t pm_sequence = 0;
+		libmodule::time::Stopwatch<1000, uint32_t> pm_uptime;
+
+		//Source for EEPManager::write_buffer (needs to stay intact while the write is in progress)
+		volatile bool pm_writing = false;
+		Record pm_record;
+		libmodule::utility::Buffer pm_buffer;
+		//Snapshot taken by push(), kept until it can be written (so a trip during a write isn't lost)
+		bool pm_pending = false;
+		Record pm_pendingrecord;
+	};
+	//Global event log
+	extern EventLog events;
+}
@@ -7,6 +7,7 @@
 
 #include "extrahardware.h"
 #include <util/delay.h>
+#include <util/atomic.h>
 
 /* SegDisplay Functional Description
  * 1. Push display data
@@ -19,6 +20,7 @@
  * 8. Switch displays
  * 9. Enable TX interrupt
  * 10. Repeat
+ * If a digit is dimmed (see set_digit_brightness), an extra timer interrupt latches 'off' part way through the period
  */
 
 /* - Push display data
@@ -33,6 +35,11 @@ constexpr uint16_t calculate_tcb2_ccmp(float const freq) {
 }
 
 extrahardware::SegDisplay * extrahardware::SegDisplay::currentinstance = nullptr;
+constexpr uint8_t extrahardware::SegDisplay::off_data;
+
+ISR(USART1_DRE_vect) {
+	extrahardware::SegDisplay::currentinstance->handle_isr_dre();
+}
 
 ISR(USART1_TXC_vect) {
 	extrahardware::SegDisplay::currentinstance->handle_isr_tx();
@@ -42,10 +49,18 @@ ISR(TCB2_INT_vect) {
 	extrahardware::SegDisplay::currentinstance->handle_isr_tcb();
 }
 
+void extrahardware::SegDisplay::handle_isr_dre()
+{
+	spi.handle_isr_dre();
+}
+
 void extrahardware::SegDisplay::handle_isr_tx()
 {
-	//Clear interrupt flag (should do this automatically?)
-	USART1.STATUS = USART_TXCIF_bm;
+	spi.handle_isr_txc();
+}
+
+void extrahardware::SegDisplay::shiftout_complete()
+{
 	//If off was pushed, turn off RCLK and return
 	if(pushed_off) {
 		//Switch to standby sleep mode
@@ -58,7 +73,7 @@ void extrahardware::SegDisplay::handle_isr_tx()
 	PORTC.OUTSET = 1 << 1;
 	//Push 'off'
 	pushed_off = true;
-	USART1.TXDATAL = 0xff;
+	spi.push_buffer(&off_data, 1);
 }
 
 void extrahardware::SegDisplay::handle_isr_tcb()
@@ -66,15 +81,26 @@ void extrahardware::SegDisplay::handle_isr_tcb()
 	//Clear interrupt flag
 	TCB2.INTFLAGS = TCB_CAPT_bm;
 
+	//If the digit is dimmed, latch 'off' (already pushed) and wait for the end of the digit period
+	if(latchoff_early) {
+		latchoff_early = false;
+		//RCLK on (latched for 'off'), it is turned off again when switching digits
+		PORTC.OUTSET = 1 << 1;
+		//Go back to digit switch frequency, and continue from where counter left off
+		uint16_t const elapsed = TCB2.CCMP;
+		TCB2.CCMP = calculate_tcb2_ccmp(config_frequency_digitswitch);
+		TCB2.CNT = elapsed;
+		return;
+	}
 	//If off was pushed, latch off and push data for next digit
 	if(pushed_off) {
 		//Switch to idle sleep mode
 		SLPCTRL.CTRLA = SLPCTRL_SMODE_IDLE_gc | SLPCTRL_SEN_bm;
 		//RCLK on (latched for 'off')
 		PORTC.OUTSET = 1 << 1;
-		//Push 'digit'
+		//Push 'digit' (or 'off' if the digit has 0 brightness)
 		pushed_off = false;
-		USART1.TXDATAL = digitdata[nextdigit];
+		spi.push_buffer(brightness[nextdigit] == 0 ? &off_data : &digitdata[nextdigit], 1);
 		//Toggle next digit
 		nextdigit ^= 1;
 
@@ -85,12 +111,34 @@ void extrahardware::SegDisplay::handle_isr_tcb()
 	//If digit data is currently being pushed, turn off RCLK and toggle digit pin to get ready for latching next digit
 	//Toggle digit select pin, RCLK off (latched for 'off')
 	PORTC.OUTTGL = (1 << 3) | (1 << 1);
-	//Go back to digit switch frequency, and continue from where counter left off
-	TCB2.CCMP = calculate_tcb2_ccmp(config_frequency_digitswitch);
+	//The digit being pushed is the one before nextdigit
+	uint8_t const currentdigit = nextdigit ^ 1;
+	//If it is dimmed, interrupt again to latch 'off' part way through the period
+	if(brightness[currentdigit] != 0xff && brightness[currentdigit] != 0) {
+		latchoff_early = true;
+		TCB2.CCMP = ccmp_latchoff[currentdigit];
+	}
+	//Otherwise go back to digit switch frequency
+	else
+		TCB2.CCMP = calculate_tcb2_ccmp(config_frequency_digitswitch);
+	//Continue from where counter left off
 	TCB2.CNT = calculate_tcb2_ccmp(config_baudrate / 4);// + TCB2.CNT;
 }
 
-extrahardware::SegDisplay::SegDisplay()
+void extrahardware::SegDisplay::set_digit_brightness(uint8_t const pos, uint8_t const brightness)
+{
+	//'off' can only be latched once it has been pushed after the digit (two bytes into the period), plus 4 bits for interrupt latency
+	constexpr uint16_t ccmp_min = calculate_tcb2_ccmp(config_baudrate / 20);
+	constexpr uint16_t ccmp_period = calculate_tcb2_ccmp(config_frequency_digitswitch);
+	uint16_t const ccmp = ccmp_min + static_cast<uint32_t>(ccmp_period - ccmp_min) * brightness / 0xff;
+	//Both are used by handle_isr_tcb
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		this->brightness[pos] = brightness;
+		ccmp_latchoff[pos] = ccmp;
+	}
+}
+
+extrahardware::SegDisplay::SegDisplay() : spi(USART1, config_baudrate)
 {
 	currentinstance = this;
 	//Enable invert for SER, RCLK, SRCLK and select
@@ -102,15 +150,8 @@ extrahardware::SegDisplay::SegDisplay()
 	//Select first digit
 	PORTC.OUTSET = 1 << 3;
 
-	//---Use USART in master SPI mode for pushing data
-	//Enable transmit complete interrupt
-	USART1.CTRLA = USART_TXCIE_bm;
-	//Enable transmitter
-	USART1.CTRLB = USART_TXEN_bm;
-	//Master SPI mode, MSB first, leading edge
-	USART1.CTRLC = USART_CMODE_MSPI_gc;
-	//100kHz buad rate
-	USART1.BAUD = (F_CPU / (2 * config_baudrate)) << 6;
+	//---Use USART in master SPI mode for pushing data (set up by spi)
+	spi.set_callbacks(this);
 
 	//---Enable TCB2 as character switch interrupt
 	//Set to 120Hz (overall refresh rate of 60Hz)
@@ -9,20 +9,37 @@
 
 #include <avr/io.h>
 #include <libmodule.h>
+#include <generalhardware.h>
 
 namespace extrahardware {
-	class SegDisplay : public libmodule::userio::IC_LTD_2601G_11 {
+	class SegDisplay : public libmodule::userio::IC_LTD_2601G_11, public libmodule::userio::ShiftOut::Callbacks {
 	public:
 		static SegDisplay *currentinstance;
 		
+		void handle_isr_dre();
 		void handle_isr_tx();
 		void handle_isr_tcb();
 
+		//Brightness is set by latching 'off' part way through the digit period (the rest of the period is spent in standby)
+		//The shortest on time is limited by the time it takes to push 'off' after the digit is latched (the digit is latched ~8 bits into the period, 'off' at 20 bits at the earliest),
+		//so any brightness above 0 is on for at least ~14% of the digit period (~12 of 83 bit times), compared to ~90% at full brightness
+		void set_digit_brightness(uint8_t const pos, uint8_t const brightness) override;
+
 		SegDisplay();
 	private:
+		void shiftout_complete() override;
+
 		static constexpr uint32_t config_baudrate = 10000;
 		static constexpr uint32_t config_frequency_digitswitch = 120;
+		//Segments all off (common anode)
+		static constexpr uint8_t off_data = 0xff;
+		libmicavr::USARTSPI spi;
 		bool pushed_off = true;
+		//True when the next TCB interrupt is to latch 'off' before the end of the digit period
+		bool latchoff_early = false;
 		uint8_t nextdigit = 0;
+		uint8_t brightness[2] = {0xff, 0xff};
+		//TCB2 count (from the start of the digit period) at which 'off' is latched for each digit
+		uint16_t ccmp_latchoff[2] = {0, 0};
 	};
 }
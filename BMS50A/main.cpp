@@ -17,6 +17,7 @@
 #include "sensors.h"
 #include "bmsui.h"
 #include "config.h"
+#include "eventlog.h"
 #include "extrahardware.h"
 
 //This fills ram with "BABA" on startup
@@ -35,7 +36,7 @@ void _stackfill(void)
         *pos = 0x41424142; // ends up as endless ascii BABA
 }
 
-libmodule::userio::ic_ldt_2601g_11_fontdata::Font segfont::english_font = {&(english_serial::pgm_arr[0]), english_len};
+libmodule::userio::ic_ldt_2601g_11_fontdata::Font segfont::english_font = {&(english_ascii::pgm_arr[0])};
 extrahardware::SegDisplay segs;
 
 void libmodule::hw::panic() {
@@ -86,24 +87,40 @@ int main(void) {
 
 	//Setup Dpad
 	libmicavr::PortIn input_dpad_common(PORTA, 1);
-	libmicavr::PortOut output_dpad_mux_s0(PORTA, 2);
-	libmicavr::PortOut output_dpad_mux_s1(PORTA, 3);
+	libmicavr::StaticPortOut<libmicavr::StaticPin<libmicavr::port::A, 2>> output_dpad_mux_s0;
+	libmicavr::StaticPortOut<libmicavr::StaticPin<libmicavr::port::A, 3>> output_dpad_mux_s1;
 
 	libmodule::userio::BinaryOutput<uint8_t, 2> binaryoutput_mux_s;
 	binaryoutput_mux_s.set_digiout_bit(0, &output_dpad_mux_s0);
 	binaryoutput_mux_s.set_digiout_bit(1, &output_dpad_mux_s1);
 
-	libmodule::userio::MultiplexDigitalInput<libmodule::userio::BinaryOutput<uint8_t, 2>> mdi_dpad_left(&input_dpad_common, &binaryoutput_mux_s, 0);
-	libmodule::userio::MultiplexDigitalInput<libmodule::userio::BinaryOutput<uint8_t, 2>> mdi_dpad_up(&input_dpad_common, &binaryoutput_mux_s, 1);
-	libmodule::userio::MultiplexDigitalInput<libmodule::userio::BinaryOutput<uint8_t, 2>> mdi_dpad_centre(&input_dpad_common, &binaryoutput_mux_s, 2);
-	libmodule::userio::MultiplexDigitalInput<libmodule::userio::BinaryOutput<uint8_t, 2>> mdi_dpad_down(&input_dpad_common, &binaryoutput_mux_s, 3);
+	//Mux is scanned once per frame (before the dpad is updated)
+	using MuxScanner_t = libmodule::userio::MultiplexScanner<libmodule::userio::BinaryOutput<uint8_t, 2>>;
+	MuxScanner_t muxscanner_dpad(&input_dpad_common, &binaryoutput_mux_s);
+	MuxScanner_t::Channel mdi_dpad_left(&muxscanner_dpad, 0);
+	MuxScanner_t::Channel mdi_dpad_up(&muxscanner_dpad, 1);
+	MuxScanner_t::Channel mdi_dpad_centre(&muxscanner_dpad, 2);
+	MuxScanner_t::Channel mdi_dpad_down(&muxscanner_dpad, 3);
 	libmicavr::PortIn input_dpad_right(PORTA, 0);
 
-	ui_common.dpad.left.set_input(&mdi_dpad_left);
-	ui_common.dpad.up.set_input(&mdi_dpad_up);
-	ui_common.dpad.centre.set_input(&mdi_dpad_centre);
-	ui_common.dpad.down.set_input(&mdi_dpad_down);
-	ui_common.dpad.right.set_input(&input_dpad_right);
+	//Every dpad button is debounced together (once per frame, after the mux scan)
+	libmodule::userio::Debouncer<> debouncer_dpad;
+	debouncer_dpad.set_input(0, &mdi_dpad_left);
+	debouncer_dpad.set_input(1, &mdi_dpad_up);
+	debouncer_dpad.set_input(2, &mdi_dpad_centre);
+	debouncer_dpad.set_input(3, &mdi_dpad_down);
+	debouncer_dpad.set_input(4, &input_dpad_right);
+	libmodule::userio::Debouncer<>::Channel debounced_dpad_left(&debouncer_dpad, 0);
+	libmodule::userio::Debouncer<>::Channel debounced_dpad_up(&debouncer_dpad, 1);
+	libmodule::userio::Debouncer<>::Channel debounced_dpad_centre(&debouncer_dpad, 2);
+	libmodule::userio::Debouncer<>::Channel debounced_dpad_down(&debouncer_dpad, 3);
+	libmodule::userio::Debouncer<>::Channel debounced_dpad_right(&debouncer_dpad, 4);
+
+	ui_common.dpad.left.set_input(&debounced_dpad_left);
+	ui_common.dpad.up.set_input(&debounced_dpad_up);
+	ui_common.dpad.centre.set_input(&debounced_dpad_centre);
+	ui_common.dpad.down.set_input(&debounced_dpad_down);
+	ui_common.dpad.right.set_input(&debounced_dpad_right);
 
 	libmodule::userio::RapidInput3L1k::Level rapidinput_level_0 = {500, 250};
 	libmodule::userio::RapidInput3L1k::Level rapidinput_level_1 = {1500, 100};
@@ -121,8 +138,8 @@ int main(void) {
 	ui::statdisplay::setup();
 
 	//Setup BMS
-	libmicavr::PortOut output_relay_left(PORTF, 0);
-	libmicavr::PortOut output_relay_right(PORTF, 1);
+	libmicavr::StaticPortOut<libmicavr::StaticPin<libmicavr::port::F, 0>> output_relay_left;
+	libmicavr::StaticPortOut<libmicavr::StaticPin<libmicavr::port::F, 1>> output_relay_right;
 	bms::BMS sys_bms;
 	sys_bms.set_digiout_relayLeft(&output_relay_left);
 	sys_bms.set_digiout_relayRight(&output_relay_right);
@@ -141,6 +158,8 @@ int main(void) {
 	
 	//Load prevoius settings from EEPROM
 	config::settings.load();
+	//Find the end of the event log
+	eventlog::events.load();
 
 	//Start timer daemons and enable interrupts
 	libmodule::time::start_timer_daemons<1000>();
@@ -152,6 +171,8 @@ int main(void) {
 			timer = config::ticks_main_system_refresh;
 
 			//Update common UI elements
+			muxscanner_dpad.scan();
+			debouncer_dpad.update();
 			ui_common.dpad.left.update();
 			ui_common.dpad.right.update();
 			ui_common.dpad.up.update();
@@ -165,6 +186,8 @@ int main(void) {
 			bms::snc::cycle_read();
 
 			sys_bms.update();
+			//Finishes saving settings that didn't fit in the EEPROM write queue
+			config::settings.update();
 
 			libmicavr::ADCManager::next_cycle();
 		}
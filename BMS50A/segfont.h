@@ -248,15 +248,11 @@ namespace segfont {
 	constexpr size_t english_len = sizeof english_const / sizeof(ConstDigit);
 
 	template <size_t ...seq>
-	struct english_serial_t {
-		static SerialDigit const pgm_arr[sizeof...(seq)];
+	struct english_ascii_t {
+		static uint8_t const pgm_arr[sizeof...(seq)];
 	};
 	template <size_t ...seq>
-	SerialDigit const english_serial_t<seq...>::pgm_arr[] PROGMEM = {conv_constdigit_to_serialdigit(english_const[seq])...};
-	using english_serial = english_serial_t<0,1,2,3,4,5,6,7,8,9,
-											10,11,12,13,14,15,16,17,18,19,
-											20,21,22,23,24,25,26,27,28,29,
-											30,31,32,33,34,35,36,37,38,39,
-											40,41,42,43,44>;
+	uint8_t const english_ascii_t<seq...>::pgm_arr[] PROGMEM = {conv_constdigits_to_ascii(english_const, seq)...};
+	using english_ascii = make_sequence<english_ascii_t>::type;
 	extern Font english_font;
 }
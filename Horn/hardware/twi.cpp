@@ -57,10 +57,20 @@ void hw::TWISlave0::set_callbacks(Callbacks *const callbacks)
 
 void hw::TWISlave0::set_address(uint8_t const addr)
 {
-	TWI0.SADDR = addr << 1;
+	//Keep the general call recognition bit
+	TWI0.SADDR = addr << 1 | (TWI0.SADDR & 0x01);
 }
 
-void hw::TWISlave0::set_recvBuffer(uint8_t buf[], uint8_t const len)
+void hw::TWISlave0::set_generalcall(bool const enable)
+{
+	//Bit 0 of SADDR enables general call recognition
+	if(enable)
+		TWI0.SADDR |= 0x01;
+	else
+		TWI0.SADDR &= ~0x01;
+}
+
+void hw::TWISlave0::set_recvBuffer(uint8_t buf[], uint16_t const len)
 {
 	//TODO: See if something like pm_recvbuf = {buf, len, pos};
 	pm_recvbuf.buf = buf;
@@ -68,7 +78,7 @@ void hw::TWISlave0::set_recvBuffer(uint8_t buf[], uint8_t const len)
 	enableCheck();
 }
 
-void hw::TWISlave0::set_sendBuffer(uint8_t const buf[], uint8_t const len)
+void hw::TWISlave0::set_sendBuffer(uint8_t const buf[], uint16_t const len)
 {
 	pm_sendbuf.buf = buf;
 	pm_sendbuf.len = len;
@@ -24,8 +24,9 @@ namespace hw {
 		TransactionInfo lastTransaction() override;
 		void set_callbacks(Callbacks *const callbacks) override;
 		void set_address(uint8_t const addr) override;
-		void set_recvBuffer(uint8_t buf[], uint8_t const len) override;
-		void set_sendBuffer(uint8_t const buf[], uint8_t const len) override;
+		void set_generalcall(bool const enable) override;
+		void set_recvBuffer(uint8_t buf[], uint16_t const len) override;
+		void set_sendBuffer(uint8_t const buf[], uint16_t const len) override;
 
 		TWISlave0();
 	private:
@@ -49,13 +50,13 @@ namespace hw {
 		//For these pos could be combined into one
 		struct {
 			uint8_t *buf = nullptr;
-			uint8_t len = 0;
+			uint16_t len = 0;
 		} volatile pm_recvbuf;
 		struct {
 			uint8_t const *buf = nullptr;
-			uint8_t len = 0;
+			uint16_t len = 0;
 		} volatile pm_sendbuf;
-		uint8_t pm_bufpos = 0;
+		uint16_t pm_bufpos = 0;
 	};
 	namespace inst {
 		extern TWISlave0 twiSlave0;
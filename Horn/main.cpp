@@ -38,6 +38,7 @@ int main(void)
 	horn.set_id(00);
 	horn.set_name("Horn");
 	horn.set_operational(true);
+	horn.set_timesync(true);
 
 
 	libtiny816::LED led_green_inst(libtiny816::hw::PINPORT::LED_GREEN, libtiny816::hw::PINPOS::LED_GREEN);
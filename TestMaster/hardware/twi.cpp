@@ -50,7 +50,7 @@ bool hw::TWIMaster0::communicating() const
 	return pm_operation != Operation::None;
 }
 
-void hw::TWIMaster0::writeBuffer(uint8_t const addr, uint8_t const buf[], uint8_t const len /*= 0*/)
+void hw::TWIMaster0::writeBuffer(uint8_t const addr, uint8_t const buf[], uint16_t const len /*= 0*/)
 {
 	pm_callbackType = CallbackType::WriteBuffer_Complete;
 	pm_operation = Operation::WriteBuffer;
@@ -62,7 +62,7 @@ void hw::TWIMaster0::writeBuffer(uint8_t const addr, uint8_t const buf[], uint8_
 	startTransaction(addr, Direction::Write);
 }
 
-void hw::TWIMaster0::readBuffer(uint8_t const addr, uint8_t buf[], uint8_t const len /*= 0*/)
+void hw::TWIMaster0::readBuffer(uint8_t const addr, uint8_t buf[], uint16_t const len /*= 0*/)
 {
 	pm_callbackType = CallbackType::ReadBuffer_Complete;
 	pm_operation = Operation::ReadBuffer;
@@ -72,7 +72,7 @@ void hw::TWIMaster0::readBuffer(uint8_t const addr, uint8_t buf[], uint8_t const
 	startTransaction(addr, Direction::Read);
 }
 
-void hw::TWIMaster0::writeReadBuffer(uint8_t const addr, uint8_t const writebuf[], uint8_t const writelen, uint8_t readbuf[], uint8_t const readlen /*= 0*/)
+void hw::TWIMaster0::writeReadBuffer(uint8_t const addr, uint8_t const writebuf[], uint16_t const writelen, uint8_t readbuf[], uint16_t const readlen /*= 0*/)
 {
 	pm_callbackType = CallbackType::WriteReadBuffer_Complete;
 	pm_operation = Operation::WriteReadBuffer;
@@ -85,7 +85,7 @@ void hw::TWIMaster0::writeReadBuffer(uint8_t const addr, uint8_t const writebuf[
 	startTransaction(addr, Direction::Write);
 }
 
-void hw::TWIMaster0::writeToAddress(uint8_t const addr, uint8_t const regaddr, uint8_t const buf[], uint8_t const len /*= 0*/)
+void hw::TWIMaster0::writeToAddress(uint8_t const addr, uint8_t const regaddr, uint8_t const buf[], uint16_t const len /*= 0*/)
 {
 	pm_callbackType = CallbackType::WriteToAddress_Complete;
 	pm_operation = Operation::WriteToAddress;
@@ -96,7 +96,7 @@ void hw::TWIMaster0::writeToAddress(uint8_t const addr, uint8_t const regaddr, u
 	startTransaction(addr, Direction::Write);
 }
 
-void hw::TWIMaster0::readFromAddress(uint8_t const addr, uint8_t const regaddr, uint8_t buf[], uint8_t const len /*= 0*/)
+void hw::TWIMaster0::readFromAddress(uint8_t const addr, uint8_t const regaddr, uint8_t buf[], uint16_t const len /*= 0*/)
 {
 	pm_callbackType = CallbackType::ReadFromAddress_Complete;
 	pm_operation = Operation::ReadFromAddress;
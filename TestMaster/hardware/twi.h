@@ -36,21 +36,24 @@ namespace hw {
 		virtual bool communicating() const = 0;
 
 		//Writes to slave until NACK or (len > 0 ? len : '\0' inclusive)
-		virtual void writeBuffer(uint8_t const addr, uint8_t const buf[], uint8_t const len = 0) = 0;
+		virtual void writeBuffer(uint8_t const addr, uint8_t const buf[], uint16_t const len = 0) = 0;
 		//Reads from slave until '\0' or len (when len > 0)
-		virtual void readBuffer(uint8_t const addr, uint8_t buf[], uint8_t const len = 0) = 0;
+		virtual void readBuffer(uint8_t const addr, uint8_t buf[], uint16_t const len = 0) = 0;
 
 		//Write to slave writebuf, and then with a repeated start read from slave into readbuf (until NACK or len)
-		virtual void writeReadBuffer(uint8_t const addr, uint8_t const writebuf[], uint8_t const writelen, uint8_t readbuf[], uint8_t const readlen = 0) = 0;
+		virtual void writeReadBuffer(uint8_t const addr, uint8_t const writebuf[], uint16_t const writelen, uint8_t readbuf[], uint16_t const readlen = 0) = 0;
 
 		//Write to slave the register address, and then write data
-		virtual void writeToAddress(uint8_t const addr, uint8_t const regaddr, uint8_t const buf[], uint8_t const len = 0) = 0;
+		virtual void writeToAddress(uint8_t const addr, uint8_t const regaddr, uint8_t const buf[], uint16_t const len = 0) = 0;
 		//Write to slave the register address, and then read data
-		virtual void readFromAddress(uint8_t const addr, uint8_t const regaddr, uint8_t buf[], uint8_t const len = 0) = 0;
+		virtual void readFromAddress(uint8_t const addr, uint8_t const regaddr, uint8_t buf[], uint16_t const len = 0) = 0;
 
 		//Check whether a slave with with the respective address is on the bus
 		virtual void checkForAddress(uint8_t const addr) = 0;
 
+		//Gives the priority and deadline (in ms, 0 for none) of the next operation. Used when the bus is shared (see rt::twi::BusScheduler), hardware masters ignore it.
+		virtual void hint(uint8_t const priority, uint16_t const deadline) {}
+
 		enum class CallbackType : uint8_t {
 			WriteBuffer_Complete,
 			ReadBuffer_Complete,
@@ -74,13 +77,13 @@ namespace hw {
 		inline bool ready() const override;
 		bool communicating() const override;
 
-		void writeBuffer(uint8_t const addr, uint8_t const buf[], uint8_t const len = 0) override;
-		void readBuffer(uint8_t const addr, uint8_t buf[], uint8_t const len = 0) override;
+		void writeBuffer(uint8_t const addr, uint8_t const buf[], uint16_t const len = 0) override;
+		void readBuffer(uint8_t const addr, uint8_t buf[], uint16_t const len = 0) override;
 
-		void writeReadBuffer(uint8_t const addr, uint8_t const writebuf[], uint8_t const writelen, uint8_t readbuf[], uint8_t const readlen = 0) override;
+		void writeReadBuffer(uint8_t const addr, uint8_t const writebuf[], uint16_t const writelen, uint8_t readbuf[], uint16_t const readlen = 0) override;
 
-		void writeToAddress(uint8_t const addr, uint8_t const regaddr, uint8_t const buf[], uint8_t const len = 0) override;
-		void readFromAddress(uint8_t const addr, uint8_t const regaddr, uint8_t buf[], uint8_t const len = 0) override;
+		void writeToAddress(uint8_t const addr, uint8_t const regaddr, uint8_t const buf[], uint16_t const len = 0) override;
+		void readFromAddress(uint8_t const addr, uint8_t const regaddr, uint8_t buf[], uint16_t const len = 0) override;
 
 		void checkForAddress(uint8_t const addr) override;
 
@@ -130,13 +133,13 @@ namespace hw {
 
 		struct {
 			uint8_t *buf = nullptr;
-			uint8_t len = 0;
-			uint8_t pos = 0;
+			uint16_t len = 0;
+			uint16_t pos = 0;
 		} volatile pm_readbuf;
 		struct {
 			uint8_t const *buf = nullptr;
-			uint8_t len = 0;
-			uint8_t pos = 0;
+			uint16_t len = 0;
+			uint16_t pos = 0;
 		} volatile pm_writebuf;
 		uint8_t pm_toAddress_regaddr = 0;
 
@@ -13,6 +13,7 @@
 #include <libmodule/timer.h>
 #include <libmodule/userio.h>
 #include "runtime/module.h"
+#include "runtime/scheduler.h"
 
 using sample_t = uint16_t;
 
@@ -71,7 +72,19 @@ int main(void)
 	pattern.repeat = true;
 	pattern.count = 3;
 
-	rt::twi::ModuleScanner modulescanner(hw::inst::twiMaster0);
+	//All TWI traffic goes through the scheduler, each user has its own channel
+	//TestMaster only tests one module at a time (the LEDs and buttons are for that module, and there isn't the RAM for more than one module master),
+	//so there is only one module channel. A master running several modules would give each its own BusChannel.
+	rt::twi::BusScheduler busscheduler(hw::inst::twiMaster0);
+	rt::twi::BusChannel channel_scanner(busscheduler);
+	//Module traffic is given priority over scanning, and should get the bus within one update interval
+	rt::twi::BusChannel channel_module(busscheduler, 1, 1000 / 30);
+	rt::twi::BusChannel channel_timesync(busscheduler);
+
+	//Modules timestamp in master time
+	rt::module::TimeSync timesync(channel_timesync);
+
+	rt::twi::ModuleScanner modulescanner(channel_scanner);
 	rt::module::Master *currentmodule = nullptr;
 	
 	//For SpeedMonitor
@@ -108,17 +121,19 @@ int main(void)
 				//Allocate memory
 				switch(modulemode) {
 				default:
-				case metadata::key::MotorController:
 					led_green_inst.set(true);
 					//[[fallthrough]];
 				case metadata::key::Horn:
-					currentmodule = new rt::module::Horn(hw::inst::twiMaster0, modulescanner.foundModule().addr);
+					currentmodule = new rt::module::Horn(channel_module, modulescanner.foundModule().addr);
 					break;
 				case metadata::key::SpeedMonitor:
-					currentmodule = new rt::module::SpeedMonitorManager<sample_t>(hw::inst::twiMaster0, modulescanner.foundModule().addr);
+					currentmodule = new rt::module::SpeedMonitorManager<sample_t>(channel_module, modulescanner.foundModule().addr);
 					break;
 				case metadata::key::MotorMover:
-					currentmodule = new rt::module::MotorMover(hw::inst::twiMaster0, modulescanner.foundModule().addr);
+					currentmodule = new rt::module::MotorMover(channel_module, modulescanner.foundModule().addr);
+					break;
+				case metadata::key::MotorController:
+					currentmodule = new rt::module::MotorController(channel_module, modulescanner.foundModule().addr);
 					break;
 				}
 				if(currentmodule == nullptr) libmodule::hw::panic();
@@ -131,6 +146,10 @@ int main(void)
 			case State::Scan:
 				//If a module needs to be deallocated
 				if(currentmodule != nullptr) {
+					//Make sure nothing is still being read into the module buffers
+					channel_module.cancel();
+					while(channel_module.communicating())
+						busscheduler.update();
 					currentmodule->~Master();
 					free(currentmodule);
 					currentmodule = nullptr;
@@ -231,6 +250,8 @@ int main(void)
 			break;
 		}
 
+		timesync.update();
+		busscheduler.update();
 		led_red.update();
 		button_test.update();
 	}
@@ -12,37 +12,39 @@
 using namespace libmodule::module;
 
 //Common registers
-rt::twi::RegisterDesc libmodule::module::metadata::horn::RegMetadata[] = {
-	//write, regular, next, len, [pos]
-	{false, false, false, 2 + 1 + 1 + metadata::com::NameLength}, //Header + Signature + ID + Name
-	{false, true, false, 1}, //Status
-	{true, false, false, 1}  //Settings
-};
-
+rt::twi::RegisterTable<metadata::horn::RegCount> libmodule::module::metadata::horn::RegMetadata(com::Layout);
 //Common + SpeedMonitorManager registers
-rt::twi::RegisterDesc libmodule::module::metadata::speedmonitormanager::RegMetadata[] = {
-	//write, regular, next, len, [pos]
-	{false, false, false, 2 + 1 + 1 + metadata::com::NameLength}, //Header + Signature + ID + Name
-	{false, true, false, 1}, //Status
-	{true, false, false, 1}, //Settings
-	{false, false, false, 1 + 1} //InstanceCount + SampleCount
-};
-
+rt::twi::RegisterTable<metadata::speedmonitormanager::RegCount> libmodule::module::metadata::speedmonitormanager::RegMetadata(com::Layout, speedmonitor::ManagerLayout);
 //SpeedMonitor registers
-rt::twi::RegisterDesc libmodule::module::metadata::speedmonitor::RegMetadata[] = {
-	//write, regular, next, len, [pos]
-	{false, false, true, sizeof(rps_t) + sizeof(cps_t)}, //RPS + TPS (next is true so that these are read when the number of instances are determined)
-	{false, true, false, 1}, //Sample pos
-	{false, true, false, 0} //Buffer
-};
+rt::twi::RegisterTable<metadata::speedmonitor::RegCount> libmodule::module::metadata::speedmonitor::RegMetadata(ConstantLayout, SampleLayout);
+//SpeedMonitor registers in stream mode (reading the stream registers drains the module's FIFO)
+rt::twi::RegisterTable<metadata::speedmonitor::StreamRegCount> libmodule::module::metadata::speedmonitor::StreamRegMetadata(ConstantLayout, StreamLayout);
+//Common + MotorMover registers
+rt::twi::RegisterTable<metadata::motormover::RegCount> libmodule::module::metadata::motormover::RegMetadata(com::Layout, Layout);
+//Common + MotorController registers
+rt::twi::RegisterTable<metadata::motorcontroller::RegCount> libmodule::module::metadata::motorcontroller::RegMetadata(com::Layout, Layout);
+
+rt::twi::ModuleRegMeta libmodule::module::metadata::horn::TWIDescriptor{RegMetadata.regs, RegCount};
+rt::twi::ModuleRegMeta libmodule::module::metadata::motormover::TWIDescriptor{RegMetadata.regs, RegCount};
+rt::twi::ModuleRegMeta libmodule::module::metadata::motorcontroller::TWIDescriptor{RegMetadata.regs, RegCount};
+
+void rt::twi::ModuleScanner::scan(uint8_t const startaddress /*= 1*/, uint8_t const endaddress /*= 127*/, bool const oneshot /*= true*/)
+{
+	pm_enumerate = false;
+	start(startaddress, endaddress, oneshot);
+}
 
-rt::twi::ModuleRegMeta libmodule::module::metadata::horn::TWIDescriptor{RegMetadata, RegCount};
+void rt::twi::ModuleScanner::enumerate(uint8_t const startaddress /*= 1*/, uint8_t const endaddress /*= 127*/)
+{
+	pm_enumerate = true;
+	start(startaddress, endaddress, true);
+}
 
 uint8_t rt::twi::ModuleScanner::found() const
 {
 	//If found, return address and found flag
 	if(pm_state == State::Found)
-		return 0x80 | pm_currentaddress;
+		return 0x80 | pm_descriptor.addr;
 	//If not found, but still scanning return 0x00
 	if(pm_state == State::Scanning || pm_state == State::Reading)
 		return 0x00;
@@ -55,6 +57,16 @@ rt::twi::ModuleDescriptor rt::twi::ModuleScanner::foundModule() const
 	return pm_descriptor;
 }
 
+uint8_t rt::twi::ModuleScanner::count() const
+{
+	return pm_cachecount;
+}
+
+rt::twi::ModuleDescriptor const & rt::twi::ModuleScanner::module(uint8_t const index) const
+{
+	return pm_cache[index];
+}
+
 void rt::twi::ModuleScanner::update()
 {
 	using namespace libmodule::module;
@@ -68,31 +80,59 @@ void rt::twi::ModuleScanner::update()
 		//[[fallthrough]];
 	case State::Scanning:
 		TWIScanner::update();
-		//If a device was found on the TWI bus, and reads 0x5E (for module), then read from register address 0 header, signature and id
-		if(pm_found && readbuf[0] == metadata::com::Header[0]) {
-			twimaster.readFromAddress(pm_currentaddress, 0x00, readbuf, sizeof readbuf);
-			pm_state = State::Reading;
+		if(pm_found) {
+			//If a device was found on the TWI bus, and reads 0x5E (for module), then read from register address 0 header, signature and id
+			if(readbuf[0] == metadata::com::Header[0])
+				readModule(pm_currentaddress);
+			//Not a module, keep going
+			else if(!sweep(pm_currentaddress + 1))
+				pm_state = State::Idle;
 		}
+		else if(!pm_scanning)
+			pm_state = State::Idle;
 		break;
-	case State::Reading:
-		if(twimaster.attention()) {
-			//Check that it was a successful read, and the header is correct
-			//memcmp has +1 because 0x5E will be read twice (one for static header byte, one for reading from addr 0x00)
-			if(twimaster.result() == hw::TWIMaster::Result::Success &&
-			   memcmp(readbuf + 1, metadata::com::Header, sizeof metadata::com::Header) == 0) {
-				//Read signature and id
-				pm_descriptor.addr = pm_currentaddress;
-				pm_descriptor.signature = readbuf[metadata::com::offset::Signature + 1];
-				pm_descriptor.id = readbuf[metadata::com::offset::ID + 1];
-				pm_state = State::Found;
-			}
-			//If not, resume scanning
-			else {
-				scan(pm_startaddress, pm_endaddress, pm_oneshot, pm_currentaddress + 1);
-				pm_state = State::Scanning;
+	case State::Reading: {
+		if(!twimaster.attention())
+			break;
+		//Check that it was a successful read, and the header is correct
+		//memcmp has +1 because 0x5E will be read twice (one for static header byte, one for reading from addr 0x00)
+		bool const valid = twimaster.result() == hw::TWIMaster::Result::Success &&
+		                   memcmp(readbuf + 1, metadata::com::Header, sizeof metadata::com::Header) == 0;
+		if(valid) {
+			//Read signature and id
+			pm_descriptor.signature = readbuf[metadata::com::offset::Signature + 1];
+			pm_descriptor.id = readbuf[metadata::com::offset::ID + 1];
+			cache_add(pm_descriptor);
+		}
+		//Cached modules that no longer respond are forgotten
+		if(pm_probeindex != 0xff) {
+			if(valid)
+				pm_probeindex++;
+			else
+				cache_remove(pm_probeindex);
+		}
+		if(valid && !pm_enumerate) {
+			pm_found = true;
+			pm_scanning = false;
+			pm_state = State::Found;
+			break;
+		}
+		//Check the next cached module, then sweep the bus
+		if(pm_probeindex != 0xff) {
+			if(pm_probeindex < pm_cachecount) {
+				readModule(pm_cache[pm_probeindex].addr);
+				break;
 			}
+			pm_probeindex = 0xff;
+			if(!sweep(pm_startaddress))
+				pm_state = State::Idle;
+			break;
 		}
+		//Resume scanning
+		if(!sweep(pm_currentaddress + 1))
+			pm_state = State::Idle;
 		break;
+		}
 	}
 }
 
@@ -105,6 +145,66 @@ void rt::twi::ModuleScanner::addressCheck(uint8_t const addr)
 	twimaster.readBuffer(addr, readbuf, 1);
 }
 
+void rt::twi::ModuleScanner::start(uint8_t const startaddress, uint8_t const endaddress, bool const oneshot)
+{
+	pm_startaddress = startaddress;
+	pm_endaddress = endaddress;
+	pm_oneshot = oneshot;
+	pm_found = false;
+	pm_scanning = true;
+	if(pm_cachecount > 0) {
+		pm_probeindex = 0;
+		readModule(pm_cache[0].addr);
+	}
+	else {
+		pm_probeindex = 0xff;
+		if(!sweep(startaddress))
+			pm_state = State::Idle;
+	}
+}
+
+void rt::twi::ModuleScanner::readModule(uint8_t const addr)
+{
+	pm_descriptor.addr = addr;
+	twimaster.readFromAddress(addr, 0x00, readbuf, sizeof readbuf);
+	pm_state = State::Reading;
+}
+
+bool rt::twi::ModuleScanner::sweep(uint8_t startfrom)
+{
+	if(startfrom >= pm_endaddress) {
+		if(pm_oneshot) {
+			pm_found = false;
+			pm_scanning = false;
+			return false;
+		}
+		startfrom = pm_startaddress;
+	}
+	TWIScanner::scan(pm_startaddress, pm_endaddress, pm_oneshot, startfrom);
+	pm_state = State::Scanning;
+	return true;
+}
+
+void rt::twi::ModuleScanner::cache_add(ModuleDescriptor const &descriptor)
+{
+	for(uint8_t i = 0; i < pm_cachecount; i++) {
+		if(pm_cache[i].addr == descriptor.addr) {
+			pm_cache[i] = descriptor;
+			return;
+		}
+	}
+	if(pm_cachecount < cache_size)
+		pm_cache[pm_cachecount++] = descriptor;
+}
+
+void rt::twi::ModuleScanner::cache_remove(uint8_t const index)
+{
+	for(uint8_t i = index + 1; i < pm_cachecount; i++) {
+		pm_cache[i - 1] = pm_cache[i];
+	}
+	pm_cachecount--;
+}
+
 uint8_t rt::module::Master::get_signature() const
 {
 	return buffer.serialiseRead<uint8_t>(metadata::com::offset::Signature);
@@ -120,6 +220,16 @@ char const * rt::module::Master::get_name() const
 	return reinterpret_cast<char const *>(buffer.pm_ptr + metadata::com::offset::Name);
 }
 
+libmodule::module::metadata::com::ms_t rt::module::Master::get_sync_offset() const
+{
+	return buffer.serialiseRead<metadata::com::ms_t>(metadata::com::offset::SyncOffset);
+}
+
+void rt::module::Master::refresh_sync_offset()
+{
+	buffermanager.request_read(metadata::com::offset::SyncOffset);
+}
+
 bool rt::module::Master::get_active() const
 {
 	return buffer.bit_get(metadata::com::offset::Status, metadata::com::sig::status::Active);
@@ -168,8 +278,94 @@ void rt::module::MotorMover::set_engaged(bool const state)
 	buffer.bit_set(metadata::com::offset::Settings, metadata::motormover::sig::settings::Engaged, state);
 }
 
+void rt::module::MotorController::set_voltage_max_current(uint16_t const mA)
+{
+	buffer.serialiseWrite(mA, metadata::motorcontroller::offset::Voltage_MaxCurrent);
+}
+
+void rt::module::MotorController::set_pwm_max_current(uint16_t const mA)
+{
+	buffer.serialiseWrite(mA, metadata::motorcontroller::offset::PWM_MaxCurrent);
+}
+
+uint16_t rt::module::MotorController::get_measured_current() const
+{
+	return buffer.serialiseRead<uint16_t>(metadata::motorcontroller::offset::MeasuredCurrent);
+}
+
+uint16_t rt::module::MotorController::get_measured_voltage() const
+{
+	return buffer.serialiseRead<uint16_t>(metadata::motorcontroller::offset::MeasuredVoltage);
+}
+
+rt::module::MotorController::MotorController(hw::TWIMaster &twimaster, uint8_t const twiaddr, size_t const updateInterval /*= 1000 / 30*/)
+ : Master(twimaster, twiaddr, buffer, metadata::motorcontroller::TWIDescriptor, updateInterval)
+{
+	//Clear the buffer
+	memset(buffer.pm_ptr, 0, buffer.pm_len);
+	//Run the buffermanager
+	buffermanager.run();
+}
+
+void rt::module::TimeSync::update()
+{
+	using namespace libmodule::module;
+	switch(pm_state) {
+	case State::Idle:
+		if(!pm_timer || twimaster.communicating())
+			break;
+		pm_synctime = get_time();
+		memcpy(pm_writebuf, &pm_synctime, sizeof pm_synctime);
+		//Ask to go next so that SyncAdjust stays small
+		twimaster.hint(twi::RegisterDesc::High, 1);
+		twimaster.writeToAddress(0x00, metadata::com::offset::SyncTime, pm_writebuf, sizeof pm_synctime);
+		pm_state = State::SyncTime;
+		break;
+	case State::SyncTime:
+		if(!twimaster.attention())
+			break;
+		if(twimaster.result() == hw::TWIMaster::Result::Success) {
+			pm_writebuf[0] = libmodule::utility::tmin<metadata::com::ms_t>(get_time() - pm_synctime, 0xff);
+			if(pm_writebuf[0] > 0) {
+				twimaster.hint(twi::RegisterDesc::High, 1);
+				twimaster.writeToAddress(0x00, metadata::com::offset::SyncAdjust, pm_writebuf, 1);
+				pm_state = State::SyncAdjust;
+				break;
+			}
+		}
+		else
+			m_failures++;
+		pm_timer = m_interval;
+		pm_timer.start();
+		pm_state = State::Idle;
+		break;
+	case State::SyncAdjust:
+		if(!twimaster.attention())
+			break;
+		pm_timer = m_interval;
+		pm_timer.start();
+		pm_state = State::Idle;
+		break;
+	}
+}
+
+libmodule::module::metadata::com::ms_t rt::module::TimeSync::get_time() const
+{
+	libmodule::module::metadata::com::ms_t time;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		time = pm_clock.ticks;
+	}
+	return time;
+}
+
+rt::module::TimeSync::TimeSync(hw::TWIMaster &twimaster, size_t const interval /*= 1000*/) : m_interval(interval), twimaster(twimaster)
+{
+	pm_clock.start();
+	pm_timer.finished = true;
+}
+
 rt::module::MotorMover::MotorMover(hw::TWIMaster &twimaster, uint8_t const twiaddr, size_t const updateInterval /*= 1000 / 30*/)
- : Master(twimaster, twiaddr, buffer, metadata::horn::TWIDescriptor, updateInterval)
+ : Master(twimaster, twiaddr, buffer, metadata::motormover::TWIDescriptor, updateInterval)
 {
 	//Clear the buffer
 	memset(buffer.pm_ptr, 0, buffer.pm_len);
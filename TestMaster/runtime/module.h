@@ -21,19 +21,34 @@
 namespace libmodule {
 	namespace module {
 		namespace metadata {
+			//Register tables are generated from the layouts in libmodule/metadata.h
 			namespace horn {
-				extern rt::twi::RegisterDesc RegMetadata[3];
-				static constexpr size_t RegCount = sizeof RegMetadata / sizeof(rt::twi::RegisterDesc);
+				static constexpr uint8_t RegCount = schema::regcount(com::Layout);
+				extern rt::twi::RegisterTable<RegCount> RegMetadata;
 				extern rt::twi::ModuleRegMeta TWIDescriptor;
 			}
 			//These do not have TWI descriptors because the member of SpeedMonitorManager is used
 			namespace speedmonitormanager {
-				extern rt::twi::RegisterDesc RegMetadata[4];
-				static constexpr size_t RegCount = sizeof RegMetadata / sizeof(rt::twi::RegisterDesc);
+				static constexpr uint8_t RegCount = schema::regcount(com::Layout) + schema::regcount(speedmonitor::ManagerLayout);
+				extern rt::twi::RegisterTable<RegCount> RegMetadata;
 			}
 			namespace speedmonitor {
-				extern rt::twi::RegisterDesc RegMetadata[3];
-				static constexpr size_t RegCount = sizeof RegMetadata / sizeof(rt::twi::RegisterDesc);
+				//Positions are relative to the instance, and the SampleBuffer len is 0 (both are set by SpeedMonitorManager)
+				static constexpr uint8_t RegCount = schema::regcount(ConstantLayout) + schema::regcount(SampleLayout);
+				extern rt::twi::RegisterTable<RegCount> RegMetadata;
+				//Used instead of RegMetadata in stream mode (stream positions are also relative to stream_offset())
+				static constexpr uint8_t StreamRegCount = schema::regcount(ConstantLayout) + schema::regcount(StreamLayout);
+				extern rt::twi::RegisterTable<StreamRegCount> StreamRegMetadata;
+			}
+			namespace motormover {
+				static constexpr uint8_t RegCount = schema::regcount(com::Layout) + schema::regcount(Layout);
+				extern rt::twi::RegisterTable<RegCount> RegMetadata;
+				extern rt::twi::ModuleRegMeta TWIDescriptor;
+			}
+			namespace motorcontroller {
+				static constexpr uint8_t RegCount = schema::regcount(com::Layout) + schema::regcount(Layout);
+				extern rt::twi::RegisterTable<RegCount> RegMetadata;
+				extern rt::twi::ModuleRegMeta TWIDescriptor;
 			}
 		}
 	}
@@ -48,13 +63,23 @@ namespace rt {
 		};
 		class ModuleScanner : public TWIScanner {
 		public:
+			//Maximum number of modules remembered between scans
+			static constexpr uint8_t cache_size = 8;
+			//Scans until a module is found. Modules found by previous scans are checked first (so a module that was reconnected is found in a few transactions).
+			void scan(uint8_t const startaddress = 1, uint8_t const endaddress = 127, bool const oneshot = true);
+			//Scans the whole bus once and records every module found (see count and module). Modules found by previous scans are checked first.
+			void enumerate(uint8_t const startaddress = 1, uint8_t const endaddress = 127);
 			//Returns based on state
 			// - Found: 0x80 | address
 			// - Not found, but scanning/reading: 0x00
-			// - Not found, and not scanning: 0x7f
+			// - Not found, and not scanning (or enumeration finished): 0x7f
 			uint8_t found() const;
 			//Returns the module that was found assuming found() is true
 			ModuleDescriptor foundModule() const;
+			//Number of modules in the cache
+			uint8_t count() const;
+			//Returns a module from the cache
+			ModuleDescriptor const &module(uint8_t const index) const;
 			void update() override;
 			ModuleScanner(hw::TWIMaster &twimaster);
 		private:
@@ -66,13 +91,28 @@ namespace rt {
 			} pm_state = State::Idle;
 			//Overrides from TWIScanner, instead of just checking for the address will attempt to read 1 byte
 			void addressCheck(uint8_t const addr) override;
+			//Starts checking the cache, and then sweeping the bus
+			void start(uint8_t const startaddress, uint8_t const endaddress, bool const oneshot);
+			//Reads the header, signature and id of the module at addr
+			void readModule(uint8_t const addr);
+			//Starts the sweep of the bus from startfrom (returns false if past the end in oneshot mode)
+			bool sweep(uint8_t startfrom);
+			void cache_add(ModuleDescriptor const &descriptor);
+			void cache_remove(uint8_t const index);
+
 			ModuleDescriptor pm_descriptor;
 			uint8_t readbuf[5];
+			ModuleDescriptor pm_cache[cache_size];
+			uint8_t pm_cachecount = 0;
+			//Index of the cached module being checked, 0xff when sweeping the bus
+			uint8_t pm_probeindex = 0xff;
+			//Whether all modules are being recorded (otherwise stops at the first module)
+			bool pm_enumerate = false;
 		};
 	}
 
 	namespace module {
-		//Module format: {5E, 8A, sig, id, name[8], status, settings, ...}
+		//Module format: {5E, 8A, sig, id, name[8], status, syncoffset[2], settings, synctime[2], syncadjust, ...}
 		
 		class Master {
 		public:
@@ -82,6 +122,9 @@ namespace rt {
 			
 			bool get_active() const;
 			bool get_operational() const;
+			//Master time minus module time, as of the last time it was read (read once on start, and after refresh_sync_offset)
+			libmodule::module::metadata::com::ms_t get_sync_offset() const;
+			void refresh_sync_offset();
 
 			void set_led(bool const state);
 			void set_power(bool const state);
@@ -105,26 +148,44 @@ namespace rt {
 			libmodule::utility::StaticBuffer<libmodule::module::metadata::com::offset::_size> buffer;
 		};
 
-		template <typename sample_t>
+		//In stream mode, only the samples pushed since the last read are read from the module's FIFO (up to streamchunk per cycle) instead of the whole sample buffer.
+		//The samples are put into the local copy of the sample buffer, so get_sample_pos and get_sample work the same in both modes.
+		//If more than streamchunk samples are pushed per cycle the module's FIFO fills up and samples are lost (counted in m_streamLost).
+		//The register table has room for maxcount_c instances, a module with more is a panic (maxcount_c needs to be raised).
+		template <typename sample_t, uint8_t maxcount_c = 2>
 		class SpeedMonitorManager : public Master {
+			static_assert(libmodule::module::metadata::speedmonitor::StreamRegCount <= libmodule::module::metadata::speedmonitor::RegCount, "SpeedMonitorManager register table is sized for RegCount");
 		public:
 			void update();
 
 			uint8_t get_sample_pos(uint8_t const mtr) const;
 			sample_t get_sample(uint8_t const mtr, uint8_t const sample) const;
+			//Module time the sample was taken (master time if TimeSync is used), 0 if the module doesn't timestamp samples
+			libmodule::module::metadata::com::ms_t get_sample_time(uint8_t const mtr, uint8_t const sample) const;
 			libmodule::module::metadata::speedmonitor::rps_t get_rps_constant(uint8_t const mtr) const;
 
-			SpeedMonitorManager(hw::TWIMaster &twimaster, uint8_t const twiaddr, size_t const updateInterval = 1000 / 30);
+			SpeedMonitorManager(hw::TWIMaster &twimaster, uint8_t const twiaddr, size_t const updateInterval = 1000 / 30, bool const stream = false, uint8_t const streamchunk = 4);
 			~SpeedMonitorManager();
 			uint8_t m_instancecount = 0;
 			uint8_t m_samplecount = 0;
 			bool m_ready = false;
+			//True if the module stores a timestamp with each sample
+			bool m_timestamped = false;
+			//Samples the modules dropped because the FIFO was full (stream mode only)
+			uint16_t m_streamLost = 0;
 		private:
-			uint8_t get_bufferoffset_monitor(uint8_t const mtr) const;
+			uint16_t get_bufferoffset_monitor(uint8_t const mtr) const;
+			//Size of a sample (and timestamp) in the buffer
+			uint8_t get_entry_size() const;
+			//Moves newly streamed samples into the local sample buffer
+			void stream_update(uint8_t const mtr);
 
 			libmodule::utility::Buffer buffer;
+			rt::twi::RegisterDesc pm_regs[libmodule::module::metadata::speedmonitormanager::RegCount + maxcount_c * libmodule::module::metadata::speedmonitor::RegCount];
 			rt::twi::ModuleRegMeta pm_regdescriptor;
 			uint8_t *pm_oldbuffer = nullptr;
+			bool pm_stream;
+			uint8_t pm_streamchunk;
 		};
 
 		class MotorMover : public Master {
@@ -134,24 +195,71 @@ namespace rt {
 		private:
 			libmodule::utility::StaticBuffer<libmodule::module::metadata::motormover::offset::_size> buffer;
 		};
+
+		class MotorController : public Master {
+		public:
+			void set_voltage_max_current(uint16_t const mA);
+			void set_pwm_max_current(uint16_t const mA);
+			uint16_t get_measured_current() const;
+			uint16_t get_measured_voltage() const;
+			MotorController(hw::TWIMaster &twimaster, uint8_t const twiaddr, size_t const updateInterval = 1000 / 30);
+		private:
+			libmodule::utility::StaticBuffer<libmodule::module::metadata::motorcontroller::offset::_size> buffer;
+		};
+
+		//Broadcasts the master time to every module with a TWI general call, so that modules (with set_timesync) can timestamp data in master time
+		//SyncTime is written first. Once it has been sent, SyncAdjust is written with how many ms late it was (e.g. from waiting for the bus), so that the wait doesn't end up in the module offsets.
+		//Both clocks are 1kHz timers, so modules are aligned to within about 1ms
+		class TimeSync {
+		public:
+			void update();
+			//Master time (ms)
+			libmodule::module::metadata::com::ms_t get_time() const;
+
+			TimeSync(hw::TWIMaster &twimaster, size_t const interval = 1000);
+			//Time between broadcasts (ms). Module clocks run from their own oscillators, so drift apart between broadcasts.
+			size_t m_interval;
+			//Number of broadcasts that no module acknowledged
+			uint16_t m_failures = 0;
+		private:
+			hw::TWIMaster &twimaster;
+			enum class State : uint8_t {
+				Idle,
+				SyncTime,
+				SyncAdjust,
+			} pm_state = State::Idle;
+			libmodule::Stopwatch1k pm_clock;
+			libmodule::Timer1k pm_timer;
+			//Master time that was written to SyncTime
+			libmodule::module::metadata::com::ms_t pm_synctime = 0;
+			uint8_t pm_writebuf[sizeof(libmodule::module::metadata::com::ms_t)];
+		};
 }
 }
 
-template <typename sample_t>
-void rt::module::SpeedMonitorManager<sample_t>::update()
+template <typename sample_t, uint8_t maxcount_c /*= 2*/>
+void rt::module::SpeedMonitorManager<sample_t, maxcount_c>::update()
 {
 	using namespace libmodule::module;
 	uint8_t samplesize = (buffer.serialiseRead<uint8_t>(metadata::com::offset::Status) & metadata::speedmonitor::mask::status::SampleSize) >> metadata::speedmonitor::sig::status::SampleSize;
 	//Cannot work with SpeedMonitors of different sample size
 	if(samplesize != sizeof(sample_t)) return;
 
+	if(m_ready && pm_stream) {
+		for(uint8_t i = 0; i < m_instancecount; i++)
+			stream_update(i);
+	}
+
 	uint8_t samplecount = buffer.serialiseRead<uint8_t>(metadata::speedmonitor::offset::manager::SampleCount);
 	uint8_t instancecount = buffer.serialiseRead<uint8_t>(metadata::speedmonitor::offset::manager::InstanceCount);
 	//This is used to make sure that the buffer has properly updated (from reading information) before making changes
 	if(samplecount > 0 && instancecount > 0 && m_samplecount != samplecount) {
+		//Instances past maxcount_c don't fit in the register table (maxcount_c needs to be raised for this module)
+		if(instancecount > maxcount_c) libmodule::hw::panic();
 		m_instancecount = instancecount;
 		m_samplecount = samplecount;
-		uint8_t const total_len = get_bufferoffset_monitor(instancecount);
+		m_timestamped = buffer.bit_get(metadata::com::offset::Status, metadata::speedmonitor::sig::status::Timestamped);
+		uint16_t const total_len = get_bufferoffset_monitor(m_instancecount);
 		//Keep pointer of old buffer since it will need to be freed after the BufferManager transfers to the new one
 		pm_oldbuffer = buffer.pm_ptr;
 		//Give buffermanager new buffer to transfer to
@@ -170,33 +278,36 @@ void rt::module::SpeedMonitorManager<sample_t>::update()
 		//Indicate that the transfer has completed
 		buffermanager.m_new_buffer.pm_len = 0;
 		//Fill out new register information (buffermanager uses a reference, so updating local one is fine)
-		pm_regdescriptor.count = metadata::speedmonitormanager::RegCount + m_instancecount * metadata::speedmonitor::RegCount;
-		pm_regdescriptor.regs = static_cast<rt::twi::RegisterDesc *>(realloc(pm_regdescriptor.regs, pm_regdescriptor.count * sizeof(rt::twi::RegisterDesc)));
-		//Copy in instance metadata
+		uint8_t const instance_regcount = pm_stream ? metadata::speedmonitor::StreamRegCount : metadata::speedmonitor::RegCount;
+		pm_regdescriptor.count = metadata::speedmonitormanager::RegCount + m_instancecount * instance_regcount;
+		//Copy in instance metadata (table positions are relative to the instance)
 		for(uint8_t i = 0; i < m_instancecount; i++) {
-			uint8_t instance_reg_zero = metadata::speedmonitormanager::RegCount + i * metadata::speedmonitor::RegCount;
-			memcpy(&(pm_regdescriptor.regs[instance_reg_zero]), metadata::speedmonitor::RegMetadata, sizeof metadata::speedmonitor::RegMetadata);
-			//Set the buffer size in the buffer register. Buffer should be the last reg (therefore RegCount - 1)
-			pm_regdescriptor.regs[instance_reg_zero + metadata::speedmonitor::RegCount - 1].len = sizeof(sample_t) * m_samplecount;
+			auto regs = &(pm_regs[metadata::speedmonitormanager::RegCount + i * instance_regcount]);
+			uint16_t const offset = get_bufferoffset_monitor(i);
+			memcpy(regs, pm_stream ? metadata::speedmonitor::StreamRegMetadata.regs : metadata::speedmonitor::RegMetadata.regs, instance_regcount * sizeof(rt::twi::RegisterDesc));
+			for(uint8_t j = 0; j < instance_regcount; j++)
+				regs[j].pos += offset;
+			if(pm_stream) {
+				//Count + Lost + as many samples as are read each cycle
+				regs[1].pos += metadata::speedmonitor::offset::stream_offset(m_samplecount, get_entry_size());
+				regs[1].len += get_entry_size() * libmodule::utility::tmin(pm_streamchunk, m_samplecount);
+			}
+			else
+				regs[2].len = get_entry_size() * m_samplecount;
 		}
-		//Update position information for new regs
-		pm_regdescriptor.processPositions();
 		m_ready = true;
 	}
 }
 
-template <typename sample_t>
-rt::module::SpeedMonitorManager<sample_t>::SpeedMonitorManager(hw::TWIMaster &twimaster, uint8_t const twiaddr, size_t const updateInterval /*= 1000 / 30*/)
- : Master(twimaster, twiaddr, buffer, pm_regdescriptor, updateInterval)
+template <typename sample_t, uint8_t maxcount_c /*= 2*/>
+rt::module::SpeedMonitorManager<sample_t, maxcount_c>::SpeedMonitorManager(hw::TWIMaster &twimaster, uint8_t const twiaddr, size_t const updateInterval /*= 1000 / 30*/, bool const stream /*= false*/, uint8_t const streamchunk /*= 4*/)
+ : Master(twimaster, twiaddr, buffer, pm_regdescriptor, updateInterval), pm_stream(stream), pm_streamchunk(streamchunk)
 {
 	using namespace libmodule::module;
-	//Allocate memory and copy in the register metadata for the manager
-	pm_regdescriptor.regs = static_cast<rt::twi::RegisterDesc *>(malloc(sizeof metadata::speedmonitormanager::RegMetadata));
-	memcpy(pm_regdescriptor.regs, metadata::speedmonitormanager::RegMetadata, sizeof metadata::speedmonitormanager::RegMetadata);
+	//Copy in the register metadata for the manager
+	memcpy(pm_regs, metadata::speedmonitormanager::RegMetadata.regs, sizeof metadata::speedmonitormanager::RegMetadata.regs);
+	pm_regdescriptor.regs = pm_regs;
 	pm_regdescriptor.count = metadata::speedmonitormanager::RegCount;
-	//Need to call these here since there was no memory allocated when these were called in MasterBufferManager
-	pm_regdescriptor.processPositions();
-	pm_regdescriptor.allNextUpdate();
 	//Allocate memory for buffer
 	buffer.pm_ptr = static_cast<uint8_t *>(malloc(metadata::speedmonitor::offset::manager::_size));
 	buffer.pm_len = metadata::speedmonitor::offset::manager::_size;
@@ -205,26 +316,52 @@ rt::module::SpeedMonitorManager<sample_t>::SpeedMonitorManager(hw::TWIMaster &tw
 	buffermanager.run();
 }
 
-template <typename sample_t>
-rt::module::SpeedMonitorManager<sample_t>::~SpeedMonitorManager()
+template <typename sample_t, uint8_t maxcount_c /*= 2*/>
+rt::module::SpeedMonitorManager<sample_t, maxcount_c>::~SpeedMonitorManager()
 {
 	using namespace libmodule::module;
 	if(pm_oldbuffer != nullptr && pm_oldbuffer != buffer.pm_ptr)
 		free(pm_oldbuffer);
 	free(buffer.pm_ptr);
-	free(pm_regdescriptor.regs);
 }
 
-template <typename sample_t>
-uint8_t rt::module::SpeedMonitorManager<sample_t>::get_bufferoffset_monitor(uint8_t const mtr) const
+template <typename sample_t, uint8_t maxcount_c /*= 2*/>
+uint16_t rt::module::SpeedMonitorManager<sample_t, maxcount_c>::get_bufferoffset_monitor(uint8_t const mtr) const
 {
 	using namespace libmodule::module;
-	uint8_t const monitor_len = metadata::speedmonitor::offset::instance::SampleBuffer + sizeof(sample_t) * m_samplecount;
+	uint16_t const monitor_len = metadata::speedmonitor::offset::instance_size(m_samplecount, get_entry_size());
 	return metadata::speedmonitor::offset::manager::_size + mtr * monitor_len;
 }
 
-template <typename sample_t>
-uint8_t rt::module::SpeedMonitorManager<sample_t>::get_sample_pos(uint8_t const mtr) const
+template <typename sample_t, uint8_t maxcount_c /*= 2*/>
+uint8_t rt::module::SpeedMonitorManager<sample_t, maxcount_c>::get_entry_size() const
+{
+	return sizeof(sample_t) + (m_timestamped ? sizeof(libmodule::module::metadata::com::ms_t) : 0);
+}
+
+template <typename sample_t, uint8_t maxcount_c /*= 2*/>
+void rt::module::SpeedMonitorManager<sample_t, maxcount_c>::stream_update(uint8_t const mtr)
+{
+	using namespace libmodule::module;
+	uint8_t *const monitor = buffer.pm_ptr + get_bufferoffset_monitor(mtr);
+	uint8_t const entrysize = get_entry_size();
+	uint8_t *const stream = monitor + metadata::speedmonitor::offset::stream_offset(m_samplecount, entrysize);
+	//Count is zeroed once the samples are taken, so each read is only used once
+	uint8_t const count = libmodule::utility::tmin(stream[metadata::speedmonitor::offset::stream::Count], libmodule::utility::tmin(pm_streamchunk, m_samplecount));
+	uint8_t &samplepos = monitor[metadata::speedmonitor::offset::instance::SamplePos];
+	//Only the local copy is changed (these regs aren't written to the module), so the buffer callbacks are not needed
+	for(uint8_t i = 0; i < count; i++) {
+		if(++samplepos >= m_samplecount)
+			samplepos = 0;
+		memcpy(monitor + metadata::speedmonitor::offset::instance::SampleBuffer + samplepos * entrysize, stream + metadata::speedmonitor::offset::stream::Buffer + i * entrysize, entrysize);
+	}
+	m_streamLost += stream[metadata::speedmonitor::offset::stream::Lost];
+	stream[metadata::speedmonitor::offset::stream::Count] = 0;
+	stream[metadata::speedmonitor::offset::stream::Lost] = 0;
+}
+
+template <typename sample_t, uint8_t maxcount_c /*= 2*/>
+uint8_t rt::module::SpeedMonitorManager<sample_t, maxcount_c>::get_sample_pos(uint8_t const mtr) const
 {
 	using namespace libmodule::module;
 	if(mtr >= m_instancecount)
@@ -232,17 +369,26 @@ uint8_t rt::module::SpeedMonitorManager<sample_t>::get_sample_pos(uint8_t const
 	return buffer.serialiseRead<uint8_t>(get_bufferoffset_monitor(mtr) + metadata::speedmonitor::offset::instance::SamplePos);
 }
 
-template <typename sample_t>
-sample_t rt::module::SpeedMonitorManager<sample_t>::get_sample(uint8_t const mtr, uint8_t const sample) const
+template <typename sample_t, uint8_t maxcount_c /*= 2*/>
+sample_t rt::module::SpeedMonitorManager<sample_t, maxcount_c>::get_sample(uint8_t const mtr, uint8_t const sample) const
 {
 	using namespace libmodule::module;
 	if(mtr >= m_instancecount || sample >= m_samplecount)
 		return 0;
-	return buffer.serialiseRead<sample_t>(get_bufferoffset_monitor(mtr) + metadata::speedmonitor::offset::instance::SampleBuffer + sample * sizeof(sample_t));
+	return buffer.serialiseRead<sample_t>(get_bufferoffset_monitor(mtr) + metadata::speedmonitor::offset::instance::SampleBuffer + sample * get_entry_size());
+}
+
+template <typename sample_t, uint8_t maxcount_c /*= 2*/>
+libmodule::module::metadata::com::ms_t rt::module::SpeedMonitorManager<sample_t, maxcount_c>::get_sample_time(uint8_t const mtr, uint8_t const sample) const
+{
+	using namespace libmodule::module;
+	if(!m_timestamped || mtr >= m_instancecount || sample >= m_samplecount)
+		return 0;
+	return buffer.serialiseRead<metadata::com::ms_t>(get_bufferoffset_monitor(mtr) + metadata::speedmonitor::offset::instance::SampleBuffer + sample * get_entry_size() + sizeof(sample_t));
 }
 
-template <typename sample_t>
-libmodule::module::metadata::speedmonitor::rps_t rt::module::SpeedMonitorManager<sample_t>::get_rps_constant(uint8_t const mtr) const
+template <typename sample_t, uint8_t maxcount_c /*= 2*/>
+libmodule::module::metadata::speedmonitor::rps_t rt::module::SpeedMonitorManager<sample_t, maxcount_c>::get_rps_constant(uint8_t const mtr) const
 {
 	using namespace libmodule::module;
 	if(mtr >= m_instancecount)
@@ -6,6 +6,7 @@
  */ 
 
 #include <stdlib.h>
+#include <util/atomic.h>
 
 #include "rttwi.h"
 
@@ -17,7 +18,7 @@ void rt::twi::TWIScanner::scan(uint8_t const startaddress, uint8_t const endaddr
 	pm_oneshot = oneshot;
 	pm_found = false;
 	pm_scanning = true;
-	addressCheck(startaddress);
+	addressCheck(pm_currentaddress);
 }
 
 uint8_t rt::twi::TWIScanner::found() const
@@ -65,18 +66,6 @@ void rt::twi::TWIScanner::addressCheck(uint8_t const addr)
 	twimaster.checkForAddress(addr);
 }
 
-void rt::twi::ModuleRegMeta::processPositions() const
-{
-	//See rttwi.h for information
-	for(uint8_t i = 0; i < count; i++) {
-		if(regs[i].pos == 0xff) {
-			if(i == 0) regs[i].pos = 0;
-			else
-				regs[i].pos = regs[i - 1].pos + regs[i - 1].len;
-		}
-	}
-}
-
 void rt::twi::ModuleRegMeta::allNextUpdate() const
 {
 	for(uint8_t i = 0; i < count; i++) {
@@ -89,13 +78,17 @@ rt::twi::MasterBufferManager::MasterBufferManager(hw::TWIMaster &twimaster, uint
 {
 	m_consecutiveCycleErrors = 0;
 	pm_cycleError = false;
+	pm_saturated = false;
 	//buffer.m_callbacks = this;
-	m_regs.processPositions();
-	m_regs.allNextUpdate();
 	if(run)
 		this->run();
 }
 
+rt::twi::MasterBufferManager::~MasterBufferManager()
+{
+	free(pm_readbuf.buf);
+}
+
 uint8_t rt::twi::MasterBufferManager::findRegIndexFromBufferPos(size_t const pos) const
 {
 	for(uint8_t i = 0; i < m_regs.count; i++) {
@@ -107,22 +100,62 @@ uint8_t rt::twi::MasterBufferManager::findRegIndexFromBufferPos(size_t const pos
 
 uint8_t rt::twi::MasterBufferManager::findRegIndexOfLastSimilar(uint8_t const regpos) const
 {
-	//If last position, can't go further
-	if(regpos + 1 >= m_regs.count) return m_regs.count;
-
+	auto &firstreg = m_regs.regs[regpos];
+	//Index of the last reg that will be included
+	uint8_t last = regpos;
 	for(uint8_t i = regpos + 1; i < m_regs.count; i++) {
-		auto &primaryreg = m_regs.regs[i - 1];
+		auto &primaryreg = m_regs.regs[last];
 		auto &secondaryreg = m_regs.regs[i];
-		//Check that both are the same direction, are adjacent in the buffer, and will be updated this cycle
-		if(secondaryreg.write == primaryreg.write
-		&& secondaryreg.pos == primaryreg.pos + primaryreg.len
-		&& (secondaryreg.queueUpdate || secondaryreg.nextUpdate || secondaryreg.regularUpdate))
-			continue;
-		//If these conditions are not met, return i
-		return i;
+		uint16_t primaryend = primaryreg.pos + primaryreg.len;
+		//Positions should be ascending, but stop if they aren't
+		if(secondaryreg.pos < primaryend) break;
+		uint16_t gap = secondaryreg.pos - primaryend;
+		//Writes have to be the same direction, adjacent in the buffer, and need updating this cycle (otherwise old data would be written)
+		if(firstreg.write) {
+			if(secondaryreg.write && gap == 0 && needsUpdatePass(secondaryreg)) {
+				last = i;
+				continue;
+			}
+			break;
+		}
+		//Reads can skip over regs (and unused bytes) as long as the gap is small enough
+		if(gap > m_readMergeGap) break;
+		//A pending write can't be skipped, since the merged read would move the regindex past it
+		if(secondaryreg.write && needsUpdatePass(secondaryreg)) break;
+		if(!secondaryreg.write && needsUpdatePass(secondaryreg))
+			last = i;
+	}
+	return last + 1;
+}
+
+bool rt::twi::MasterBufferManager::needsUpdate(RegisterDesc const &reg)
+{
+	return reg.queueUpdate || reg.nextUpdate || reg.regularUpdate;
+}
+
+bool rt::twi::MasterBufferManager::needsUpdatePass(RegisterDesc const &reg) const
+{
+	return reg.priority == pm_pass && needsUpdate(reg);
+}
+
+void rt::twi::MasterBufferManager::countMissedDeadlines()
+{
+	for(uint8_t i = 0; i < m_regs.count; i++) {
+		auto &reg = m_regs.regs[i];
+		if(reg.deadline == 0 || !needsUpdate(reg)) continue;
+		//Passes go from High to Low, so higher priority regs have already been done
+		if(reg.priority > pm_pass || (reg.priority == pm_pass && i < pm_regindex_complete)) continue;
+		m_deadlineMisses++;
+	}
+}
+
+uint16_t rt::twi::MasterBufferManager::cycleElapsed() const
+{
+	uint16_t result;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		result = pm_cycletime.ticks;
 	}
-	//All until the end were valid, return count (the end)
-	return m_regs.count;
+	return result;
 }
 
 volatile hw::TWIMaster::Result mres;
@@ -133,24 +166,34 @@ void rt::twi::MasterBufferManager::update()
 	buffer.m_callbacks = this;
 	//A new cycle
 	if(pm_timer && pm_state != State::Off) {
+		//If the last cycle hasn't finished yet, the bus can't keep up (so shed Low priority regs this cycle)
+		pm_saturated = pm_state == State::ProcessingCycle;
+		if(pm_saturated)
+			countMissedDeadlines();
 		pm_state = State::ProcessingCycle;
 		pm_cycleError = false;
 		pm_regindex_complete = 0;
 		pm_regindex_attempted = 0;
+		pm_pass = RegisterDesc::High;
 		pm_timer = m_updateInterval;
 		pm_timer.start();
+		pm_cycletime.reset();
+		pm_cycletime.start();
 	}
 	//If the TWIMaster has finished an operation
 	if(twimaster.attention()) {
+		//Regs of the other direction may still be queued from a cycle that was cut short, and were only read over
+		bool const transactionwrite = pm_currentTransaction == TransactionType::Write;
 		//If it was reading, copy the result into the client buffer
 		if(pm_currentTransaction == TransactionType::Read) {
 			if(twimaster.result() == hw::TWIMaster::Result::Success) {
-				//Copy readbuf into buffer
-				memcpy(buffer.pm_ptr + pm_readbuf.bufferoffset, pm_readbuf.buf + m_headersize, pm_readbuf.len - m_headersize);
+				//Copy the queued regs from readbuf into buffer (anything else was only read to merge the transaction)
+				for(uint8_t i = pm_regindex_complete; i < pm_regindex_attempted; i++) {
+					auto &element = m_regs.regs[i];
+					if(!element.write && element.queueUpdate)
+						memcpy(buffer.pm_ptr + element.pos, pm_readbuf.buf + m_headersize + (element.pos - pm_readbuf.bufferoffset), element.len);
+				}
 			}
-			//This is freed further down
-			//free(pm_readbuf.buf);
-			//pm_readbuf.buf = nullptr;
 		}
 		//Since the operation is finished, set TransactionType back to none
 		pm_currentTransaction = TransactionType::None;
@@ -160,8 +203,13 @@ void rt::twi::MasterBufferManager::update()
 			//If there was no error
 			if(mres == hw::TWIMaster::Result::Success) {
 				//For the elements covered, set 'NextUpdate' to false (is set during writeCallback or during first transaction)
+				uint16_t const elapsed = cycleElapsed();
 				for(uint8_t i = pm_regindex_complete; i < pm_regindex_attempted; i++) {
-					m_regs.regs[i].queueUpdate = false;
+					auto &reg = m_regs.regs[i];
+					if(reg.write != transactionwrite) continue;
+					if(reg.queueUpdate && reg.deadline != 0 && elapsed > reg.deadline)
+						m_deadlineMisses++;
+					reg.queueUpdate = false;
 				}
 				pm_regindex_complete = pm_regindex_attempted;
 			}
@@ -170,12 +218,27 @@ void rt::twi::MasterBufferManager::update()
 				m_consecutiveCycleErrors++;
 				pm_cycleError = true;
 			}
-			//Keep cycling from the successfully completed registers until a register to be read or written is found
-			for(pm_regindex_attempted = pm_regindex_complete; pm_regindex_attempted < m_regs.count; pm_regindex_attempted++) {
-				auto &element = m_regs.regs[pm_regindex_attempted];
-				//If this element is to be updated, break
-				if(element.queueUpdate || element.nextUpdate || element.regularUpdate)
+			while(true) {
+				//Keep cycling from the successfully completed registers until a register to be read or written is found
+				for(pm_regindex_attempted = pm_regindex_complete; pm_regindex_attempted < m_regs.count; pm_regindex_attempted++) {
+					//If this element is to be updated, break
+					if(needsUpdatePass(m_regs.regs[pm_regindex_attempted]))
+						break;
+				}
+				if(pm_regindex_attempted < m_regs.count || pm_pass == RegisterDesc::Low)
+					break;
+				//Nothing left in this pass, start again from the first reg with the next priority down
+				pm_pass--;
+				pm_regindex_complete = 0;
+				//Under saturation skip the Low priority regs (nextUpdate is left set, so they are done when the bus catches up)
+				if(pm_pass == RegisterDesc::Low && pm_saturated) {
+					for(uint8_t i = 0; i < m_regs.count; i++) {
+						if(needsUpdatePass(m_regs.regs[i]))
+							pm_cycleMetrics.shed++;
+					}
+					pm_regindex_attempted = m_regs.count;
 					break;
+				}
 			}
 			//If nothing was found, move onto the next cycle
 			if(pm_regindex_attempted >= m_regs.count) {
@@ -183,42 +246,72 @@ void rt::twi::MasterBufferManager::update()
 				//If there hasn't been an error this cycle, reset consecutive errors
 				if(!pm_cycleError)
 					m_consecutiveCycleErrors = 0;
+				m_lastCycleMetrics = pm_cycleMetrics;
+				pm_cycleMetrics = Metrics();
+				m_cycles++;
 				return;
 			}
 			//From here on, a read or write will occur
 			auto &element = m_regs.regs[pm_regindex_attempted];
 			//Find whether there are multiple similar regs in series (several birds with one stone)
 			auto secondary_pos = findRegIndexOfLastSimilar(pm_regindex_attempted);
-			//Queue these regs for update and set nextupdate to false
+			//Queue these regs for update and set nextupdate to false (skipping any regs a read is only reading over)
+			uint16_t neededSize = 0;
+			uint8_t deadline = 0;
 			for(uint8_t i = pm_regindex_attempted; i < secondary_pos; i++) {
-				m_regs.regs[i].nextUpdate = false;
-				m_regs.regs[i].queueUpdate = true;
+				auto &reg = m_regs.regs[i];
+				if(reg.write != element.write || !needsUpdatePass(reg)) continue;
+				reg.nextUpdate = false;
+				reg.queueUpdate = true;
+				neededSize += reg.len;
+				if(reg.deadline != 0 && (deadline == 0 || reg.deadline < deadline))
+					deadline = reg.deadline;
 			}
+			//Tell the bus scheduler how urgent this transaction is (deadline is relative to now, at least 1ms so that it isn't "no deadline")
+			uint16_t const elapsed = cycleElapsed();
+			twimaster.hint(pm_pass, deadline == 0 ? 0 : (deadline > elapsed ? deadline - elapsed : 1));
 			pm_regindex_attempted = secondary_pos;
 			//Create secondary element for convenience (above func gives past the end pos)
 			auto &secondaryelement = m_regs.regs[pm_regindex_attempted - 1];
 			//Size of buffer needed for transaction
-			uint8_t bufferSize = secondaryelement.pos + secondaryelement.len - element.pos;
+			uint16_t bufferSize = secondaryelement.pos + secondaryelement.len - element.pos;
+			uint8_t const regaddrlen = encodeRegAddr(element.pos);
 			//Write
 			if(element.write) {
 				//Make sure that the end of the transaction is not past the end of the buffer
 				if(element.pos + bufferSize <= buffer.pm_len) {
 					pm_currentTransaction = TransactionType::Write;
 					//Should really properly check that this is a valid transfer to the buffer (same with for read)
-					twimaster.writeToAddress(m_twiaddr, element.pos, buffer.pm_ptr + element.pos, bufferSize);
-
+					if(regaddrlen == 1)
+						twimaster.writeToAddress(m_twiaddr, pm_regaddr[0], buffer.pm_ptr + element.pos, bufferSize);
+					else {
+						reserveScratch(regaddrlen + bufferSize);
+						memcpy(pm_readbuf.buf, pm_regaddr, regaddrlen);
+						memcpy(pm_readbuf.buf + regaddrlen, buffer.pm_ptr + element.pos, bufferSize);
+						twimaster.writeBuffer(m_twiaddr, pm_readbuf.buf, regaddrlen + bufferSize);
+					}
+					//Address, register address, data
+					pm_cycleMetrics.transactions++;
+					pm_cycleMetrics.bytes += 1 + regaddrlen + bufferSize;
+					pm_cycleMetrics.payload += bufferSize;
 				}
 			}
 			//Read
 			else {
 				pm_currentTransaction = TransactionType::Read;
-				//Allocate new memory for read, since the header needs to be cut off when transferring into client buffer
+				//Read into scratch memory, since the header needs to be cut off when transferring into client buffer
 				pm_readbuf.len = bufferSize + m_headersize;
 				pm_readbuf.bufferoffset = element.pos;
-				if(pm_readbuf.buf != nullptr) free(pm_readbuf.buf);
-				pm_readbuf.buf = static_cast<uint8_t *>(malloc(pm_readbuf.len));
-				if(pm_readbuf.buf == nullptr) libmodule::hw::panic();
-				twimaster.readFromAddress(m_twiaddr, element.pos, pm_readbuf.buf, pm_readbuf.len);
+				reserveScratch(pm_readbuf.len);
+				if(regaddrlen == 1)
+					twimaster.readFromAddress(m_twiaddr, pm_regaddr[0], pm_readbuf.buf, pm_readbuf.len);
+				else
+					twimaster.writeReadBuffer(m_twiaddr, pm_regaddr, regaddrlen, pm_readbuf.buf, pm_readbuf.len);
+				//Address, register address, address, header and data
+				pm_cycleMetrics.transactions++;
+				pm_cycleMetrics.bytes += 2 + regaddrlen + pm_readbuf.len;
+				pm_cycleMetrics.payload += neededSize;
+				pm_cycleMetrics.gapbytes += bufferSize - neededSize;
 			}
 		}
 	}
@@ -230,7 +323,7 @@ void rt::twi::MasterBufferManager::update()
 	}
 }
 
-void rt::twi::MasterBufferManager::buffer_writeCallack(void const *const buf, size_t const len, size_t const pos)
+void rt::twi::MasterBufferManager::buffer_writeCallback(void const *const buf, size_t const len, size_t const pos)
 {
 	//If a register was written to, update it on the next cycle
 	for(auto regPos = findRegIndexFromBufferPos(pos); m_regs.regs[regPos].pos <= pos + len && regPos < m_regs.count; regPos++) {
@@ -250,10 +343,43 @@ void rt::twi::MasterBufferManager::buffer_readCallback(void *const buf, size_t c
 
 void rt::twi::MasterBufferManager::run()
 {
+	m_regs.allNextUpdate();
 	pm_state = State::Waiting;
 	pm_timer.finished = true;
 }
 
+void rt::twi::MasterBufferManager::reserveScratch(uint16_t const len)
+{
+	//Grow scratch memory if this is the biggest transaction so far (usually only happens in the first cycle)
+	if(len > pm_readbuf.capacity) {
+		pm_readbuf.buf = static_cast<uint8_t *>(realloc(pm_readbuf.buf, len));
+		if(pm_readbuf.buf == nullptr) libmodule::hw::panic();
+		pm_readbuf.capacity = len;
+	}
+}
+
+uint8_t rt::twi::MasterBufferManager::encodeRegAddr(uint16_t const pos)
+{
+	using namespace libmodule::twi;
+	//Positions below the flag are one byte either way (see SlaveBufferManager::received)
+	if(!addressing::wide(buffer.pm_len) || pos < addressing::WideFlag) {
+		pm_regaddr[0] = pos;
+		return 1;
+	}
+	pm_regaddr[0] = addressing::WideFlag | (pos >> 8);
+	pm_regaddr[1] = pos & 0xff;
+	return 2;
+}
+
+void rt::twi::MasterBufferManager::request_read(size_t const pos)
+{
+	for(uint8_t i = 0; i < m_regs.count; i++) {
+		auto &element = m_regs.regs[i];
+		if(!element.write && pos >= element.pos && pos < element.pos + element.len)
+			element.nextUpdate = true;
+	}
+}
+
 void rt::twi::MasterBufferManager::stop()
 {
 	pm_state = State::Off;
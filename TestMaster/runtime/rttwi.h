@@ -11,6 +11,8 @@
 
 #include <libmodule/utility.h>
 #include <libmodule/timer.h>
+#include <libmodule/twislave.h>
+#include <libmodule/metadata.h>
 #include "../hardware/twi.h"
 
 namespace rt {
@@ -49,22 +51,46 @@ namespace rt {
 		//    - If write, writes the data every cycle, otherwise writes when data
 		// - NextUpdate: Whether it will be updated on the next cycle
 		// - QueueUpdate: Register has been queued for update this cycle (done to prevent losing writes if NextUpdate is set while regs are being processed)
+		// - Priority: Higher priority regs are done first in a cycle, Low priority regs are skipped when the bus is saturated
+		// - Deadline: Time (in ms) from the start of a cycle that the reg should be done by, 0 for no deadline
 
 		struct RegisterDesc {
-			//A pos of 0xff will cause the position to be automatically determined based on the previous position
-			//Note: This position determination is only done on construction of MasterBufferManager (or when "processPositions" is called in ModuleRegData)
-			uint8_t len;
-			uint8_t pos;
+			enum Priority : uint8_t {
+				//Things that are only read once or rarely matter (e.g. names and constants)
+				Low = 0,
+				Normal,
+				//Things that need to be fresh (e.g. measured current)
+				High,
+			};
+			//Module register tables are generated from the metadata.h schemas (see RegisterTable)
+			uint16_t len;
+			uint16_t pos;
 			bool write : 1;
 			bool regularUpdate : 1;
 			bool nextUpdate : 1;
 			bool queueUpdate : 1;
-			constexpr RegisterDesc(bool const write, bool const regular, bool const next, uint8_t const len, uint8_t const pos = 0xff, bool const queue = false);
+			uint8_t priority : 2;
+			uint8_t deadline;
+			constexpr RegisterDesc(bool const write, bool const regular, bool const next, uint16_t const len, uint16_t const pos, bool const queue = false, Priority const priority = Normal, uint8_t const deadline = 0);
+			//Register for the field at pos (len is the size of the field, fields joined to it are added by RegisterTable)
+			constexpr RegisterDesc(libmodule::module::metadata::schema::Field const &field, uint16_t const pos);
+			constexpr RegisterDesc();
+		};
+
+		//Register descriptors generated at compile time from metadata.h layouts (in order), so they always match the module offsets
+		//Objects should be global (or static) so that the table is built by the compiler, and not at runtime
+		template <uint8_t count_c>
+		struct RegisterTable {
+			static constexpr uint8_t count = count_c;
+			RegisterDesc regs[count_c];
+			//count_c should be the sum of schema::regcount() of the layouts
+			constexpr RegisterTable(libmodule::module::metadata::schema::Layout const &first, libmodule::module::metadata::schema::Layout const &second = {nullptr, 0, 0});
+		private:
+			constexpr void append(libmodule::module::metadata::schema::Layout const &layout, uint8_t &index);
 		};
 
 		//This should probably be some sort of generic array class
 		struct ModuleRegMeta {
-			void processPositions() const;
 			void allNextUpdate() const;
 
 			RegisterDesc *regs = nullptr;
@@ -72,14 +98,18 @@ namespace rt {
 		};
 
 		//Manages a Buffer to be used on the TWI bus, assumes a register system is used
+		//Buffers longer than 255 bytes use wide register addresses (see libmodule::twi::addressing), the same as SlaveBufferManager
 		class MasterBufferManager : public libmodule::utility::Buffer::Callbacks {
 		public:
 			void update();
 
 			void run();
 			void stop();
+			//Reads the regs containing pos next cycle (for regs that aren't regularly updated)
+			void request_read(size_t const pos);
 			//Default to 30Hz
 			MasterBufferManager(hw::TWIMaster &twimaster, uint8_t const twiaddr, libmodule::utility::Buffer &buffer, ModuleRegMeta const &regs, size_t const updateInterval = 1000 / 30, uint8_t const headerCount = 0, bool const run = false);
+			~MasterBufferManager();
 			
 			//The TWI address of the slave
 			uint8_t m_twiaddr;
@@ -91,10 +121,35 @@ namespace rt {
 			uint8_t m_headersize;
 			//The number of consecutive cycles where at least 1 error has occurred
 			uint8_t m_consecutiveCycleErrors : 7;
+			//Reads separated by up to this many bytes are combined into one transaction (the bytes in between are read and discarded)
+			//Each extra transaction costs START, address, register address, repeated START, address and header, so a few wasted bytes is cheaper
+			uint8_t m_readMergeGap = 4;
+
+			//Bus usage for a cycle
+			struct Metrics {
+				//Number of TWI transactions
+				uint8_t transactions = 0;
+				//Number of bytes on the bus (including address, register address and header bytes)
+				uint16_t bytes = 0;
+				//Number of register bytes that needed to be read or written (the useful part of bytes)
+				uint16_t payload = 0;
+				//Number of bytes read only because they were between two merged reads
+				uint16_t gapbytes = 0;
+				//Number of Low priority regs skipped because the bus was saturated
+				uint8_t shed = 0;
+			};
+			//Metrics for the last completed cycle
+			Metrics m_lastCycleMetrics;
+			//Number of completed cycles
+			uint16_t m_cycles = 0;
+			//Number of times a reg was not done by its deadline
+			uint16_t m_deadlineMisses = 0;
 
 			libmodule::utility::Buffer m_new_buffer;
 		private:
 			bool pm_cycleError : 1;
+			//Set when the last cycle did not finish before the next one was due
+			bool pm_saturated : 1;
 			//Warnings were given when these were bitfields (even though they were big enough)
 			enum class State {
 				Off,
@@ -107,29 +162,85 @@ namespace rt {
 				Read,
 			} pm_currentTransaction = TransactionType::None;
 
+			Metrics pm_cycleMetrics;
+			//Regs are done in passes from High to Low priority, this is the priority of the current pass
+			uint8_t pm_pass = RegisterDesc::High;
+			//Time since the start of the cycle (for deadlines)
+			libmodule::Stopwatch1k pm_cycletime;
 			uint8_t pm_regindex_complete = 0;
 			uint8_t pm_regindex_attempted = 0;
 			hw::TWIMaster &twimaster;
 			libmodule::utility::Buffer &buffer;
 			libmodule::Timer1k pm_timer;
+			//Scratch memory for reads (needed since the header is cut off when copying into the client buffer)
+			//In wide mode writes are also put together here, since the register address is written as part of the data
+			//Only grows, so once it is big enough for the largest read no more allocations are made
 			struct {
 				uint8_t *buf = nullptr;
-				uint8_t len;
+				uint16_t len;
+				//Size of the memory allocated for buf
+				uint16_t capacity = 0;
 				//Location in client buffer of first byte
-				uint8_t bufferoffset;
+				uint16_t bufferoffset;
 			} pm_readbuf;
+			//Register address bytes for wide mode transactions
+			uint8_t pm_regaddr[2];
 			
 
+			//Grows pm_readbuf to at least len bytes
+			void reserveScratch(uint16_t const len);
+			//Puts the register address for pos into pm_regaddr, and returns the number of bytes used
+			uint8_t encodeRegAddr(uint16_t const pos);
+
 			uint8_t findRegIndexFromBufferPos(size_t const pos) const;
-			//Finds adjacent regs that will need the same operation (e.g. finds regs that are sequential all waiting for write)
+			//Finds following regs that can be done in the same transaction as regpos (e.g. finds regs that are sequential all waiting for write)
+			//Reads may also skip over regs that don't need reading (see m_readMergeGap)
 			//Note: Returns 'past the end' position [x, y)
 			uint8_t findRegIndexOfLastSimilar(uint8_t const regpos) const;
-
-			void buffer_writeCallack(void const *const buf, size_t const len, size_t const pos) override;
+			//Whether the reg needs to be read or written this cycle
+			static bool needsUpdate(RegisterDesc const &reg);
+			//Whether the reg needs to be read or written in the current pass
+			bool needsUpdatePass(RegisterDesc const &reg) const;
+			//Adds regs that have not been done yet but are past their deadline to m_deadlineMisses (called when a cycle is cut short)
+			void countMissedDeadlines();
+			//pm_cycletime.ticks, read atomically (it is incremented by the timer interrupt)
+			uint16_t cycleElapsed() const;
+
+			void buffer_writeCallback(void const *const buf, size_t const len, size_t const pos) override;
 			void buffer_readCallback(void *const buf, size_t const len, size_t const pos) override;
 		};
 	}
 }
 
-constexpr rt::twi::RegisterDesc::RegisterDesc(bool const write, bool const regular, bool const next, uint8_t const len, uint8_t const pos /*= 0xff*/, bool const queue /*= false*/)
-: write(write), regularUpdate(regular), nextUpdate(next), len(len), pos(pos), queueUpdate(queue) {}
+constexpr rt::twi::RegisterDesc::RegisterDesc(bool const write, bool const regular, bool const next, uint16_t const len, uint16_t const pos, bool const queue /*= false*/, Priority const priority /*= Normal*/, uint8_t const deadline /*= 0*/)
+: write(write), regularUpdate(regular), nextUpdate(next), len(len), pos(pos), queueUpdate(queue), priority(priority), deadline(deadline) {}
+
+constexpr rt::twi::RegisterDesc::RegisterDesc(libmodule::module::metadata::schema::Field const &field, uint16_t const pos)
+: RegisterDesc(field.access & libmodule::module::metadata::schema::access::Write, field.access & libmodule::module::metadata::schema::access::Regular, field.access & libmodule::module::metadata::schema::access::Next,
+  field.size, pos, false, static_cast<Priority>(field.priority), field.deadline) {}
+
+constexpr rt::twi::RegisterDesc::RegisterDesc() : RegisterDesc(false, false, false, 0, 0) {}
+
+template <uint8_t count_c>
+constexpr rt::twi::RegisterTable<count_c>::RegisterTable(libmodule::module::metadata::schema::Layout const &first, libmodule::module::metadata::schema::Layout const &second /*= {nullptr, 0, 0}*/) : regs{}
+{
+	uint8_t index = 0;
+	append(first, index);
+	append(second, index);
+}
+
+template <uint8_t count_c>
+constexpr void rt::twi::RegisterTable<count_c>::append(libmodule::module::metadata::schema::Layout const &layout, uint8_t &index)
+{
+	using namespace libmodule::module::metadata;
+	for(uint8_t i = 0; i < layout.count; i++) {
+		schema::Field const &field = layout.fields[i];
+		if(field.access & schema::access::None)
+			continue;
+		//Layouts are checked with schema::joins_valid, so there is always a register before a Join
+		if(field.access & schema::access::Join)
+			regs[index - 1].len += field.size;
+		else
+			regs[index++] = RegisterDesc(field, schema::offset(layout, i));
+	}
+}
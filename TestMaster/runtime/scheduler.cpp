@@ -0,0 +1,231 @@
+/*
+ * scheduler.cpp
+ *
+ * Created: 19/10/2019 11:02:31 AM
+ *  Author: teddy
+ */
+
+#include <util/atomic.h>
+#include <libmodule/utility.h>
+
+#include "scheduler.h"
+
+bool rt::twi::BusChannel::attention() const
+{
+	return pm_result != Result::Wait;
+}
+
+hw::TWIMaster::Result rt::twi::BusChannel::result() const
+{
+	return pm_result;
+}
+
+bool rt::twi::BusChannel::ready() const
+{
+	return pm_state == State::Idle;
+}
+
+bool rt::twi::BusChannel::communicating() const
+{
+	return pm_state != State::Idle;
+}
+
+void rt::twi::BusChannel::writeBuffer(uint8_t const addr, uint8_t const buf[], uint16_t const len /*= 0*/)
+{
+	queue(Operation::WriteBuffer, addr, 0, buf, len, nullptr, 0);
+}
+
+void rt::twi::BusChannel::readBuffer(uint8_t const addr, uint8_t buf[], uint16_t const len /*= 0*/)
+{
+	queue(Operation::ReadBuffer, addr, 0, nullptr, 0, buf, len);
+}
+
+void rt::twi::BusChannel::writeReadBuffer(uint8_t const addr, uint8_t const writebuf[], uint16_t const writelen, uint8_t readbuf[], uint16_t const readlen /*= 0*/)
+{
+	queue(Operation::WriteReadBuffer, addr, 0, writebuf, writelen, readbuf, readlen);
+}
+
+void rt::twi::BusChannel::writeToAddress(uint8_t const addr, uint8_t const regaddr, uint8_t const buf[], uint16_t const len /*= 0*/)
+{
+	queue(Operation::WriteToAddress, addr, regaddr, buf, len, nullptr, 0);
+}
+
+void rt::twi::BusChannel::readFromAddress(uint8_t const addr, uint8_t const regaddr, uint8_t buf[], uint16_t const len /*= 0*/)
+{
+	queue(Operation::ReadFromAddress, addr, regaddr, nullptr, 0, buf, len);
+}
+
+void rt::twi::BusChannel::checkForAddress(uint8_t const addr)
+{
+	queue(Operation::CheckForAddress, addr, 0, nullptr, 0, nullptr, 0);
+}
+
+void rt::twi::BusChannel::registerCallback(Callback_t const callback)
+{
+	pm_callback = callback;
+}
+
+void rt::twi::BusChannel::hint(uint8_t const priority, uint16_t const deadline)
+{
+	pm_hintpriority = priority;
+	pm_hintdeadline = deadline;
+}
+
+void rt::twi::BusChannel::cancel()
+{
+	if(pm_state != State::Pending) return;
+	pm_state = State::Idle;
+	pm_result = Result::Error;
+}
+
+rt::twi::BusChannel::BusChannel(BusScheduler &scheduler, uint8_t const priority /*= 0*/, uint16_t const deadline /*= 0*/)
+ : m_priority(priority), m_deadline(deadline), scheduler(scheduler)
+{
+	scheduler.channel_on_new(this);
+}
+
+rt::twi::BusChannel::~BusChannel()
+{
+	scheduler.channel_on_delete(this);
+}
+
+void rt::twi::BusChannel::queue(Operation const operation, uint8_t const addr, uint8_t const regaddr, uint8_t const writebuf[], uint16_t const writelen, uint8_t readbuf[], uint16_t const readlen)
+{
+	pm_operation = operation;
+	pm_addr = addr;
+	pm_regaddr = regaddr;
+	pm_writebuf = writebuf;
+	pm_writelen = writelen;
+	pm_readbuf = readbuf;
+	pm_readlen = readlen;
+	pm_queuetime = scheduler.now();
+	pm_priority = m_priority + pm_hintpriority;
+	pm_deadline = pm_hintdeadline != 0 ? pm_hintdeadline : m_deadline;
+	pm_hintpriority = 0;
+	pm_hintdeadline = 0;
+	pm_result = Result::Wait;
+	//If the operation is replacing an active one, the result of the active one will be ignored (see complete)
+	pm_state = State::Pending;
+}
+
+void rt::twi::BusChannel::start(hw::TWIMaster &twimaster)
+{
+	uint16_t waited = scheduler.now() - pm_queuetime;
+	if(waited > m_maxWait) m_maxWait = waited;
+	if(pm_deadline != 0 && waited > pm_deadline && m_deadlineMisses < 0xffff) m_deadlineMisses++;
+	pm_state = State::Active;
+	switch(pm_operation) {
+	case Operation::WriteBuffer:
+		twimaster.writeBuffer(pm_addr, pm_writebuf, pm_writelen);
+		break;
+	case Operation::ReadBuffer:
+		twimaster.readBuffer(pm_addr, pm_readbuf, pm_readlen);
+		break;
+	case Operation::WriteReadBuffer:
+		twimaster.writeReadBuffer(pm_addr, pm_writebuf, pm_writelen, pm_readbuf, pm_readlen);
+		break;
+	case Operation::WriteToAddress:
+		twimaster.writeToAddress(pm_addr, pm_regaddr, pm_writebuf, pm_writelen);
+		break;
+	case Operation::ReadFromAddress:
+		twimaster.readFromAddress(pm_addr, pm_regaddr, pm_readbuf, pm_readlen);
+		break;
+	case Operation::CheckForAddress:
+		twimaster.checkForAddress(pm_addr);
+		break;
+	default:
+		libmodule::hw::panic();
+	}
+}
+
+void rt::twi::BusChannel::complete(Result const result)
+{
+	//User queued a new operation while this one was on the bus
+	if(pm_state != State::Active) return;
+	pm_state = State::Idle;
+	pm_result = result;
+	if(pm_callback == nullptr) return;
+	//CallbackType is in the same order as Operation (without None)
+	pm_callback(static_cast<CallbackType>(static_cast<uint8_t>(pm_operation) - 1));
+}
+
+int16_t rt::twi::BusChannel::slack(uint16_t const now) const
+{
+	if(pm_deadline == 0) return 0x7fff;
+	return static_cast<int16_t>(pm_queuetime + pm_deadline - now);
+}
+
+void rt::twi::BusScheduler::update()
+{
+	if(twimaster.communicating()) return;
+	//Previous operation has finished
+	if(pm_active != nullptr) {
+		BusChannel *finished = pm_active;
+		pm_active = nullptr;
+		//Done after clearing pm_active in case the callback queues another operation
+		finished->complete(twimaster.result());
+	}
+	uint8_t next = select_next();
+	if(next >= pm_channels.size()) return;
+	pm_lastindex = next;
+	pm_active = pm_channels[next];
+	pm_active->start(twimaster);
+}
+
+bool rt::twi::BusScheduler::idle() const
+{
+	return pm_active == nullptr && select_next() >= pm_channels.size();
+}
+
+rt::twi::BusScheduler::BusScheduler(hw::TWIMaster &twimaster, Policy const policy /*= Policy::Priority*/)
+ : m_policy(policy), twimaster(twimaster)
+{
+	pm_clock.start();
+}
+
+void rt::twi::BusScheduler::channel_on_new(BusChannel *const channel)
+{
+	pm_channels.push_back(channel);
+}
+
+void rt::twi::BusScheduler::channel_on_delete(BusChannel *const channel)
+{
+	//The operation on the bus will still finish, update() waits for it before starting the next one
+	if(pm_active == channel) pm_active = nullptr;
+	pm_channels.remove(channel);
+	if(pm_lastindex >= pm_channels.size()) pm_lastindex = 0;
+}
+
+/* Search starts from the channel after the last one given the bus, and only replaces the best when a channel is strictly better.
+ * Therefore channels that are equal are given the bus in turn.
+ */
+uint8_t rt::twi::BusScheduler::select_next() const
+{
+	uint8_t const count = pm_channels.size();
+	uint8_t best = count;
+	uint16_t const time = now();
+	for(uint8_t i = 1; i <= count; i++) {
+		uint8_t index = (pm_lastindex + i) % count;
+		BusChannel const *channel = pm_channels[index];
+		if(channel->pm_state != BusChannel::State::Pending) continue;
+		if(best == count) {
+			best = index;
+			if(m_policy == Policy::RoundRobin) break;
+			continue;
+		}
+		BusChannel const *current = pm_channels[best];
+		if(channel->pm_priority > current->pm_priority ||
+		  (channel->pm_priority == current->pm_priority && channel->slack(time) < current->slack(time)))
+			best = index;
+	}
+	return best;
+}
+
+uint16_t rt::twi::BusScheduler::now() const
+{
+	uint16_t result;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		result = pm_clock.ticks;
+	}
+	return result;
+}
@@ -0,0 +1,147 @@
+/*
+ * scheduler.h
+ *
+ * Created: 19/10/2019 11:02:15 AM
+ *  Author: teddy
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <libmodule/utility.h>
+#include <libmodule/timer.h>
+#include "../hardware/twi.h"
+
+namespace rt {
+	namespace twi {
+		class BusScheduler;
+
+		//A TWIMaster given to each user of the bus (e.g. one per MasterBufferManager), so that several modules can share one hardware TWIMaster
+		//Operations are queued in the channel, and are started on the real TWIMaster by BusScheduler::update
+		//The channel behaves like a TWIMaster to its user: attention() is false from when an operation is queued until the scheduler has finished it
+		//Note: Callbacks are made from BusScheduler::update (not from an interrupt)
+		class BusChannel : public hw::TWIMaster {
+			friend BusScheduler;
+		public:
+			bool attention() const override;
+			Result result() const override;
+			bool ready() const override;
+			bool communicating() const override;
+
+			void writeBuffer(uint8_t const addr, uint8_t const buf[], uint16_t const len = 0) override;
+			void readBuffer(uint8_t const addr, uint8_t buf[], uint16_t const len = 0) override;
+
+			void writeReadBuffer(uint8_t const addr, uint8_t const writebuf[], uint16_t const writelen, uint8_t readbuf[], uint16_t const readlen = 0) override;
+
+			void writeToAddress(uint8_t const addr, uint8_t const regaddr, uint8_t const buf[], uint16_t const len = 0) override;
+			void readFromAddress(uint8_t const addr, uint8_t const regaddr, uint8_t buf[], uint16_t const len = 0) override;
+
+			void checkForAddress(uint8_t const addr) override;
+
+			void registerCallback(Callback_t const callback) override;
+			//The hinted priority is added to m_priority, and the hinted deadline replaces m_deadline (for the next operation only)
+			void hint(uint8_t const priority, uint16_t const deadline) override;
+
+			//Drops an operation that is still waiting for the bus (result becomes Error). An operation already on the bus will still finish.
+			void cancel();
+
+			BusChannel(BusScheduler &scheduler, uint8_t const priority = 0, uint16_t const deadline = 0);
+			~BusChannel();
+
+			//Higher priority channels are given the bus first (when using BusScheduler::Policy::Priority)
+			uint8_t m_priority;
+			//Time (in ms) an operation may wait for the bus before it counts as a deadline miss, 0 for no deadline (unless hinted)
+			//Channels with less time left before their deadline are given the bus first (when priorities are equal)
+			uint16_t m_deadline;
+			//Number of operations that waited longer than m_deadline for the bus
+			uint16_t m_deadlineMisses = 0;
+			//Longest time (in ms) an operation has waited for the bus
+			uint16_t m_maxWait = 0;
+		private:
+			enum class Operation : uint8_t {
+				None,
+				WriteBuffer,
+				ReadBuffer,
+				WriteReadBuffer,
+				WriteToAddress,
+				ReadFromAddress,
+				CheckForAddress,
+			} pm_operation = Operation::None;
+
+			enum class State : uint8_t {
+				//No operation, or operation finished
+				Idle,
+				//Operation is waiting for the bus
+				Pending,
+				//Operation has been started on the TWIMaster
+				Active,
+			} pm_state = State::Idle;
+
+			//Stores the operation and tells the scheduler
+			void queue(Operation const operation, uint8_t const addr, uint8_t const regaddr, uint8_t const writebuf[], uint16_t const writelen, uint8_t readbuf[], uint16_t const readlen);
+			//Starts the stored operation on twimaster
+			void start(hw::TWIMaster &twimaster);
+			//Stores the result and makes the user callback
+			void complete(Result const result);
+			//Time (in ms) left before the deadline of the pending operation (negative if missed)
+			int16_t slack(uint16_t const now) const;
+
+			BusScheduler &scheduler;
+			//Success so that users that wait for attention() before starting can start straight away
+			Result pm_result = Result::Success;
+			uint8_t pm_addr = 0;
+			uint8_t pm_regaddr = 0;
+			uint8_t const *pm_writebuf = nullptr;
+			uint16_t pm_writelen = 0;
+			uint8_t *pm_readbuf = nullptr;
+			uint16_t pm_readlen = 0;
+			//Time that the operation was queued
+			uint16_t pm_queuetime = 0;
+			//Set by hint for the next operation
+			uint8_t pm_hintpriority = 0;
+			uint16_t pm_hintdeadline = 0;
+			//Priority and deadline of the queued operation
+			uint8_t pm_priority = 0;
+			uint16_t pm_deadline = 0;
+			Callback_t pm_callback = nullptr;
+		};
+
+		//Shares one TWIMaster (normally hw::inst::twiMaster0) between several BusChannels
+		//Only one operation is on the bus at a time, update() starts the next one as soon as the previous finishes
+		//Per module update rates are still set by MasterBufferManager::m_updateInterval, the scheduler decides the order when they want the bus at the same time
+		class BusScheduler {
+			friend BusChannel;
+		public:
+			enum class Policy : uint8_t {
+				//Each channel gets the bus in turn
+				RoundRobin,
+				//Highest priority (m_priority plus hinted priority) first, then least time before deadline, then in turn
+				Priority,
+			};
+			//Call every loop
+			void update();
+			//Returns true if no operations are on the bus or waiting for it
+			bool idle() const;
+
+			BusScheduler(hw::TWIMaster &twimaster, Policy const policy = Policy::Priority);
+
+			Policy m_policy;
+		private:
+			void channel_on_new(BusChannel *const channel);
+			void channel_on_delete(BusChannel *const channel);
+			//Returns the index of the channel to start next, or pm_channels.size() if none are pending
+			uint8_t select_next() const;
+			//Current time in ms (wraps)
+			uint16_t now() const;
+
+			hw::TWIMaster &twimaster;
+			libmodule::utility::Vector<BusChannel *> pm_channels;
+			//Channel that has an operation on the bus
+			BusChannel *pm_active = nullptr;
+			//Index of the channel that was last given the bus (used for round robin)
+			uint8_t pm_lastindex = 0;
+			libmodule::Stopwatch1k pm_clock;
+		};
+	}
+}
@@ -83,18 +83,26 @@ void libarduino_m328::TWISlave0::set_callbacks(Callbacks *const callbacks)
 	pm_callbacks = callbacks;
 }
 
+void libarduino_m328::TWISlave0::set_generalcall(bool const enable)
+{
+	if(enable)
+		TWAR |= 1 << TWGCE;
+	else
+		TWAR &= ~(1 << TWGCE);
+}
+
 void libarduino_m328::TWISlave0::set_address(uint8_t const addr)
 {
 	if(!communicating()) {
-		//Set address
-		TWAR = addr << 1;
+		//Set address (keeping the general call enable bit)
+		TWAR = addr << 1 | (TWAR & 1 << TWGCE);
 		//Enable address match, TWI, and TWI interrupt
 		TWCR = 1 << TWEA | 1 << TWEN | 1 << TWIE;
 	}
 	else libmodule::hw::panic();
 }
 
-void libarduino_m328::TWISlave0::set_recvBuffer(uint8_t buf[], uint8_t const len)
+void libarduino_m328::TWISlave0::set_recvBuffer(uint8_t buf[], uint16_t const len)
 {
 	//TODO: See if something like pm_recvbuf = {buf, len, pos};
 	pm_recvbuf.buf = buf;
@@ -102,7 +110,7 @@ void libarduino_m328::TWISlave0::set_recvBuffer(uint8_t buf[], uint8_t const len
 	enableCheck();
 }
 
-void libarduino_m328::TWISlave0::set_sendBuffer(uint8_t const buf[], uint8_t const len)
+void libarduino_m328::TWISlave0::set_sendBuffer(uint8_t const buf[], uint16_t const len)
 {
 	pm_sendbuf.buf = buf;
 	pm_sendbuf.len = len;
@@ -53,8 +53,9 @@ namespace libarduino_m328 {
 		TransactionInfo lastTransaction() override;
 		void set_callbacks(Callbacks *const callbacks) override;
 		void set_address(uint8_t const addr) override;
-		void set_recvBuffer(uint8_t buf[], uint8_t const len) override;
-		void set_sendBuffer(uint8_t const buf[], uint8_t const len) override;
+		void set_generalcall(bool const enable) override;
+		void set_recvBuffer(uint8_t buf[], uint16_t const len) override;
+		void set_sendBuffer(uint8_t const buf[], uint16_t const len) override;
 
 		TWISlave0();
 	private:	
@@ -75,13 +76,13 @@ namespace libarduino_m328 {
 
 		struct {
 			uint8_t *buf = nullptr;
-			uint8_t len = 0;
+			uint16_t len = 0;
 		} volatile pm_recvbuf;
 		struct {
 			uint8_t const *buf = nullptr;
-			uint8_t len = 0;
+			uint16_t len = 0;
 		} volatile pm_sendbuf;
-		uint8_t pm_bufpos = 0;
+		uint16_t pm_bufpos = 0;
 	};
 	extern TWISlave0 twiSlave0;
 }
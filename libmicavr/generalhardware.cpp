@@ -9,6 +9,8 @@
 
 #include "generalhardware.h"
 
+#include <util/atomic.h>
+
 bool libmicavr::PortIn::get() const
 {
 	return pm_hwport.IN & 1 << pm_hwpin;
@@ -46,6 +48,61 @@ void libmicavr::PortOut::toggle()
 	pm_hwport.OUTTGL = 1 << pm_hwpin;
 }
 
+bool libmicavr::USARTSPI::push_buffer(uint8_t const buf[], uint8_t const len)
+{
+	if(pm_busy || len == 0)
+		return false;
+	pm_busy = true;
+	pm_buf = buf;
+	pm_len = len;
+	pm_pos = 1;
+	//Clear transmit complete flag from the last push, so that it only occurs once this push has finished
+	pm_hwusart.STATUS = USART_TXCIF_bm;
+	pm_hwusart.TXDATAL = buf[0];
+	//Rest of the bytes are written as the data register empties
+	pm_hwusart.CTRLA = USART_DREIE_bm;
+	return true;
+}
+
+bool libmicavr::USARTSPI::busy() const
+{
+	return pm_busy;
+}
+
+void libmicavr::USARTSPI::set_callbacks(Callbacks *const callbacks)
+{
+	pm_callbacks = callbacks;
+}
+
+void libmicavr::USARTSPI::handle_isr_dre()
+{
+	if(pm_pos < pm_len) {
+		pm_hwusart.TXDATAL = pm_buf[pm_pos++];
+		return;
+	}
+	//Last byte is in the shift register, wait for it to finish
+	pm_hwusart.CTRLA = USART_TXCIE_bm;
+}
+
+void libmicavr::USARTSPI::handle_isr_txc()
+{
+	//Clear interrupt flag
+	pm_hwusart.STATUS = USART_TXCIF_bm;
+	pm_hwusart.CTRLA = 0;
+	pm_busy = false;
+	if(pm_callbacks != nullptr)
+		pm_callbacks->shiftout_complete();
+}
+
+libmicavr::USARTSPI::USARTSPI(USART_t &usart, uint32_t const baudrate) : pm_hwusart(usart)
+{
+	//Enable transmitter
+	pm_hwusart.CTRLB = USART_TXEN_bm;
+	//Master SPI mode, MSB first, leading edge
+	pm_hwusart.CTRLC = USART_CMODE_MSPI_gc;
+	pm_hwusart.BAUD = (F_CPU / (2 * baudrate)) << 6;
+}
+
 ISR(ADC0_RESRDY_vect) {
 	libmicavr::isr_adc();
 }
@@ -200,34 +257,50 @@ void libmicavr::isr_eeprom()
 }
 
 /**
- The [EEBUSY bit](megaAVR 0-series datasheet.pdf#page=77) is returned.
- \returns \c true if there is a write (or other) operation in progress. \c false otherwise.
+ The [EEBUSY bit](megaAVR 0-series datasheet.pdf#page=77) is checked along with the write queue.
+ \returns \c true if there is a write (or other) operation in progress or queued. \c false otherwise.
 */
 bool libmicavr::EEPManager::busy()
 {
-	//If there is a command in progress then busy
-	return NVMCTRL.STATUS & NVMCTRL_EEBUSY_bm;
+	//If there is a command in progress or something waiting to be written then busy
+	return write_queue_count > 0 || (NVMCTRL.STATUS & NVMCTRL_EEBUSY_bm);
 }
 
 /**
- If the EEPROM is busy, this function will block until it is not busy.
- \n If the EEPROM is not busy, this function will setup a page write and return. Subsequent pages are written using the EEREADY interrupt.
- \n Use busy() to check for write completion.
- \todo Perhaps add an optional callback for write completion.
+ The write is added to the end of the queue and this function returns immediately. If the queue was empty, the first page write is started straight away. Subsequent pages (and queued writes) are written using the EEREADY interrupt.
+ \n If the same \a buffer, \a eeprom_offset and \a callbacks are already waiting in the queue (but not yet started), nothing new is queued since the queued write will read the latest contents of \a buffer when it starts.
+ \n Use busy() or \a callbacks to check for write completion.
  \details [Buffer::read](\ref libmodule::utility::Buffer::read(void *const, size_t const, size_t const) const) is used to source the data. This means read callbacks can be generated for [Buffer](\ref libmodule::utility::Buffer).
  \warning No copy of \a buffer is made. Ensure it is kept intact for the duration of the write.
  \param [in] buffer [Buffer](\ref libmodule::utility::Buffer) object to read from.
  \param [in] eeprom_offset Offset from \c EEPROM_START to write data (in bytes).
+ \param [in] callbacks Optional Callbacks object to notify when the write has finished.
+ \returns \c false if the queue is full and the write was not queued. \c true otherwise.
  \sa write_next_page()
 */
-void libmicavr::EEPManager::write_buffer(libmodule::utility::Buffer const &buffer, uint8_t const eeprom_offset)
+bool libmicavr::EEPManager::write_buffer(libmodule::utility::Buffer const &buffer, uint8_t const eeprom_offset, Callbacks *const callbacks /*= nullptr*/)
 {
-	//Not great, but block until the EEPROM is not busy (this should wait until an ongoing write_buffer has finished)
-	while(NVMCTRL.STATUS & NVMCTRL_EEBUSY_bm);
-	write_eeprom_position = eeprom_offset;
-	write_buffer_position = 0;
-	write_buffer_ptr = &buffer;
-	write_next_page();
+	bool result = true;
+	//Queue is also modified by the EEPROM interrupt
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		bool queued = false;
+		//Element 0 is in progress, so it can't be used to merge
+		for(uint8_t i = 1; i < write_queue_count; i++) {
+			if(write_queue[i].buffer == &buffer && write_queue[i].eeprom_offset == eeprom_offset && write_queue[i].callbacks == callbacks) {
+				queued = true;
+				break;
+			}
+		}
+		if(!queued) {
+			if(write_queue_count >= write_queue_size) result = false;
+			else {
+				write_queue[write_queue_count++] = {&buffer, eeprom_offset, callbacks};
+				//If nothing was being written, start writing this
+				if(write_queue_count == 1) start_write();
+			}
+		}
+	}
+	return result;
 }
 
 /**
@@ -242,32 +315,60 @@ void libmicavr::EEPManager::read_buffer(libmodule::utility::Buffer &buffer, uint
 	buffer.write(reinterpret_cast<void *>(EEPROM_START + eeprom_offset), len, 0);
 }
 
+void libmicavr::EEPManager::start_write()
+{
+	write_eeprom_position = write_queue[0].eeprom_offset;
+	write_buffer_position = 0;
+	write_next_page();
+}
+
 /**
- Data to write is determined using #write_eeprom_position and #write_buffer_position. Both members will have the number of bytes written added to them.
- \n The number of bytes to write is the smaller of:
+ Data to write is determined using #write_eeprom_position and #write_buffer_position. Both members will have the number of bytes compared added to them.
+ \n The number of bytes to compare is the smaller of:
 	-# The remaining bytes in the transfer.
 	-# The remaining bytes in the page.
  
- If there are no more bytes to write, this function will return without initiating another page write. Otherwise, another page write is started and the function returns.
+ Only bytes that differ from what is already in EEPROM are loaded into the page buffer. Since an erase-write only erases the bytes loaded into the page buffer, unchanged bytes are not worn. If no bytes in the page segment differ, no page write is made at all and the next segment is compared straight away.
+ \n If there are no more bytes to write, the callback for the write is made and it is removed from the queue. If there is another write queued it is started, otherwise this function will return without initiating another page write.
  \sa write_buffer(), isr_eeprom()
 */
 void libmicavr::EEPManager::write_next_page()
 {
 	//Disable EEPROM interrupt (should be disabled unless command is in progress)
 	NVMCTRL.INTCTRL = 0;
-	//Determine number of bytes remaining in the page after the offset
-	uint8_t page_bytes_remaining = EEPROM_PAGE_SIZE - (write_eeprom_position % EEPROM_PAGE_SIZE);
-	//Determine number of bytes to write
-	uint8_t write_len = libmodule::utility::tmin<uint8_t>(page_bytes_remaining, write_buffer_ptr->pm_len - write_buffer_position);
-	//If no more bytes to write, return without starting another write request
-	if(write_len == 0) {
-		write_buffer_ptr = nullptr;
-		return;
+	if(write_queue_count == 0) return;
+	libmodule::utility::Buffer const &buffer = *write_queue[0].buffer;
+	uint8_t changed_len = 0;
+	while(changed_len == 0) {
+		//Determine number of bytes remaining in the page after the offset
+		uint8_t page_bytes_remaining = EEPROM_PAGE_SIZE - (write_eeprom_position % EEPROM_PAGE_SIZE);
+		//Determine number of bytes to compare
+		uint8_t write_len = libmodule::utility::tmin<uint8_t>(page_bytes_remaining, buffer.pm_len - write_buffer_position);
+		//If no more bytes to write, finish this write and move onto the next one
+		if(write_len == 0) {
+			if(write_queue[0].callbacks != nullptr)
+				write_queue[0].callbacks->eeprom_writeCallback(buffer);
+			//Shift the queue down (it's only a few elements)
+			write_queue_count--;
+			for(uint8_t i = 0; i < write_queue_count; i++) {
+				write_queue[i] = write_queue[i + 1];
+			}
+			if(write_queue_count > 0) start_write();
+			return;
+		}
+		//Load only the changed bytes into the page buffer (reading EEPROM reads the EEPROM itself, not the page buffer)
+		for(uint8_t i = 0; i < write_len; i++) {
+			uint8_t value;
+			buffer.read(&value, 1, write_buffer_position + i);
+			volatile uint8_t *const eeprom_ptr = reinterpret_cast<volatile uint8_t *>(EEPROM_START + write_eeprom_position + i);
+			if(*eeprom_ptr != value) {
+				*eeprom_ptr = value;
+				changed_len++;
+			}
+		}
+		write_eeprom_position += write_len;
+		write_buffer_position += write_len;
 	}
-	//Read data to be written into page buffer
-	write_buffer_ptr->read(reinterpret_cast<void *>(EEPROM_START + write_eeprom_position), write_len, write_buffer_position);
-	write_eeprom_position += write_len;
-	write_buffer_position += write_len;
 	//Make an erase-write operation for the current page (for EEPROM will only erase bytes that were written in the page buffer)
 	CCP = CCP_SPM_gc;
 	NVMCTRL.CTRLA = NVMCTRL_CMD_PAGEERASEWRITE_gc;
@@ -280,4 +381,5 @@ void libmicavr::EEPManager::write_next_page()
 
 uint8_t libmicavr::EEPManager::write_eeprom_position = 0;
 uint8_t libmicavr::EEPManager::write_buffer_position = 0;
-libmodule::utility::Buffer const *libmicavr::EEPManager::write_buffer_ptr = nullptr;
+libmicavr::EEPManager::Write libmicavr::EEPManager::write_queue[write_queue_size];
+volatile uint8_t libmicavr::EEPManager::write_queue_count = 0;
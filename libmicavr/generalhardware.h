@@ -10,6 +10,7 @@
 #include <avr/io.h>
 #include <libmodule/utility.h>
 #include <libmodule/twislave.h>
+#include <libmodule/74hc595.h>
 
 namespace libmicavr {
 //--- Port functionality ---
@@ -31,6 +32,55 @@ namespace libmicavr {
 		uint8_t const pm_hwpin;
 	};
 
+	namespace port {
+		enum e : uint8_t {
+			A, B, C, D, E, F,
+		};
+	}
+	//Pin known at compile time. Accesses go through the VPORT (in the bottom of IO space), so set() and toggle() compile to a single sbi/cbi instruction.
+	//Use directly (e.g. StaticPin<port::A, 2>::set(true)) in time critical code, or through StaticPortOut where an Output<bool>* is needed
+	template <port::e port_c, uint8_t pin_c>
+	struct StaticPin {
+		static constexpr uint8_t mask = 1 << pin_c;
+		static void set(bool const p);
+		static void toggle();
+		static bool get();
+		//Makes the pin an output, and inverts it if invert is true
+		static void init_output(bool const invert = false);
+	};
+	//Adapter for StaticPin, for use wherever an Output<bool>* is taken
+	//Costs one virtual call, but no port/pin lookups (unlike PortOut)
+	template <typename pin_t>
+	class StaticPortOut : public libmodule::utility::Output<bool> {
+	public:
+		void set(bool const p) override;
+		void toggle() override;
+		StaticPortOut(bool const invert = false);
+	};
+
+//--- USART functionality ---
+	//Shifts bytes out of a USART in master SPI mode (MSB first, leading edge), one byte per data register empty interrupt
+	//XCK and TxD are not set as outputs here, since the pins depend on PORTMUX (set the pins as outputs before pushing)
+	//The project defines ISR(USARTn_DRE_vect) and ISR(USARTn_TXC_vect) for the USART, and calls handle_isr_dre and handle_isr_txc from them
+	class USARTSPI : public libmodule::userio::ShiftOut {
+	public:
+		bool push_buffer(uint8_t const buf[], uint8_t const len) override;
+		bool busy() const override;
+		void set_callbacks(Callbacks *const callbacks) override;
+
+		void handle_isr_dre();
+		void handle_isr_txc();
+
+		USARTSPI(USART_t &usart, uint32_t const baudrate);
+	private:
+		USART_t &pm_hwusart;
+		Callbacks *pm_callbacks = nullptr;
+		uint8_t const *pm_buf = nullptr;
+		uint8_t pm_len = 0;
+		uint8_t pm_pos = 0;
+		volatile bool pm_busy = false;
+	};
+
 //--- ADC functionality ---
 	void isr_adc();
 	
@@ -105,32 +155,106 @@ namespace libmicavr {
 	 \brief Interrupt based EEPROM utilities.
 	 
 	 EEPManager allows easy reading and writing to EEPROM using libmodule::utility::Buffer objects for input and output. All members are static.
-	 \n If no write operation is in progress, the write function is non-blocking and will return immediately. EEPROM page management is handled automatically using interrupts.
-	 \n If a write operation is in progress, the write function will block until the current operation is complete.
+	 \n The write function is non-blocking and will always return immediately. Writes are queued (up to #write_queue_size) and EEPROM page management is handled automatically using interrupts.
+	 \n Writes only change the bytes that differ from the current EEPROM contents (see write_next_page()), so rewriting a mostly unchanged Buffer is cheap and doesn't wear EEPROM.
+	 \n A Callbacks object can be given to be notified when a write has finished.
 	 \author Teddy.Hut
 	*/
 	class EEPManager {
 		friend void isr_eeprom();
 	public:
-		///Returns \c true if there is a write operation in progress.
+		/** \brief Abstract callback class for EEPManager.
+		 \details Inherit and override #eeprom_writeCallback to be notified when a write has completed.
+		 */
+		class Callbacks {
+			friend EEPManager;
+			/** \brief Called after the last page of a write has been written.
+			 \warning This is called from the EEPROM interrupt, so keep it short.
+			 \param [in] buffer The Buffer that was passed to write_buffer().
+			 */
+			virtual void eeprom_writeCallback(libmodule::utility::Buffer const &buffer) = 0;
+		};
+
+		///Maximum number of writes that can be queued (including the one in progress).
+		static constexpr uint8_t write_queue_size = 4;
+
+		///Returns \c true if there is a write operation in progress or queued.
 		static bool busy();
 
 		//Writes the buffer to EEPROM. Will return before finishing, and uses a pointer to the buffer (no copy is made).
 		//Ensure the buffer is kept intact.
-		///Writes entire contents of \a buffer to EEPROM at position \a eeprom_offset.
-		static void write_buffer(libmodule::utility::Buffer const &buffer, uint8_t const eeprom_offset);
+		///Queues the entire contents of \a buffer to be written to EEPROM at position \a eeprom_offset.
+		static bool write_buffer(libmodule::utility::Buffer const &buffer, uint8_t const eeprom_offset, Callbacks *const callbacks = nullptr);
 		///Reads \a len bytes from EEPROM at position \a eeprom_offset to the start of \a buffer.
 		static void read_buffer(libmodule::utility::Buffer &buffer, uint8_t const eeprom_offset, uint8_t const len);
 	private:
+		///A queued write_buffer() call.
+		struct Write {
+			libmodule::utility::Buffer const *buffer;
+			uint8_t eeprom_offset;
+			Callbacks *callbacks;
+		};
+		///Sets up the write at the front of the queue and starts writing it.
+		static void start_write();
 		///Write next queued page segment to EEPROM.
 		static void write_next_page();
 		///Next EEPROM destination for a page write.
 		static uint8_t write_eeprom_position;
-		///Position to read from #write_buffer_ptr in the next page write.
+		///Position to read from the current write buffer in the next page write.
 		static uint8_t write_buffer_position;
-		///Pointer to buffer holding the source data for an ongoing write operation.
-		static libmodule::utility::Buffer const *write_buffer_ptr;
+		///Queued writes. Element 0 is the write in progress.
+		static Write write_queue[write_queue_size];
+		///Number of elements in #write_queue.
+		static volatile uint8_t write_queue_count;
 	};
 
 	/**@}*/
 }
+
+template <libmicavr::port::e port_c, uint8_t pin_c>
+void libmicavr::StaticPin<port_c, pin_c>::set(bool const p)
+{
+	//VPORTs are next to each other, so a constant index still gives a constant address
+	if(p)
+		(&VPORTA)[port_c].OUT |= mask;
+	else
+		(&VPORTA)[port_c].OUT &= ~mask;
+}
+
+template <libmicavr::port::e port_c, uint8_t pin_c>
+void libmicavr::StaticPin<port_c, pin_c>::toggle()
+{
+	//Writing a 1 to IN toggles OUT
+	(&VPORTA)[port_c].IN = mask;
+}
+
+template <libmicavr::port::e port_c, uint8_t pin_c>
+bool libmicavr::StaticPin<port_c, pin_c>::get()
+{
+	return (&VPORTA)[port_c].IN & mask;
+}
+
+template <libmicavr::port::e port_c, uint8_t pin_c>
+void libmicavr::StaticPin<port_c, pin_c>::init_output(bool const invert /*= false*/)
+{
+	(&VPORTA)[port_c].DIR |= mask;
+	if(invert) *(&(&PORTA)[port_c].PIN0CTRL + pin_c) = PORT_INVEN_bm;
+}
+
+template <typename pin_t>
+void libmicavr::StaticPortOut<pin_t>::set(bool const p)
+{
+	pin_t::set(p);
+}
+
+template <typename pin_t>
+void libmicavr::StaticPortOut<pin_t>::toggle()
+{
+	pin_t::toggle();
+}
+
+template <typename pin_t>
+libmicavr::StaticPortOut<pin_t>::StaticPortOut(bool const invert /*= false*/)
+{
+	pin_t::init_output(invert);
+}
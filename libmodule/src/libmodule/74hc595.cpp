@@ -8,9 +8,20 @@
 #include "74hc595.h"
 
 #include <util/delay.h>
+#include <util/atomic.h>
 
 void libmodule::userio::IC_74HC595::push_buffer(void const *const ptr, size_t const len) const
 {
+	if(shiftout != nullptr && msbfirst) {
+		//ShiftOut takes up to 255 bytes at a time
+		for(size_t i = 0; i < len; i += 0xff) {
+			while(shiftout->busy());
+			shiftout->push_buffer(static_cast<uint8_t const *>(ptr) + i, utility::tmin<size_t>(len - i, 0xff));
+		}
+		//Data has to be in the registers before returning (e.g. for latch_regs)
+		while(shiftout->busy());
+		return;
+	}
 	for(size_t i = 0; i < len; i++) {
 		push_data<uint8_t>(static_cast<uint8_t const *>(ptr)[i]);
 	}
@@ -31,7 +42,10 @@ void libmodule::userio::IC_74HC595::push_data<bool>(bool const data) const
 template <>
 void libmodule::userio::IC_74HC595::push_data<uint8_t>(uint8_t const data) const
 {
-	if(msbfirst) {
+	if(shiftout != nullptr && msbfirst) {
+		push_buffer(&data, 1);
+	}
+	else if(msbfirst) {
 		for(uint8_t i = 0x80; i != 0; i >>= 1) {
 			push_data<bool>(data & i);
 		}
@@ -44,6 +58,26 @@ void libmodule::userio::IC_74HC595::push_data<uint8_t>(uint8_t const data) const
 }
 
 
+bool libmodule::userio::IC_74HC595::push_chain(uint8_t const buf[], uint8_t const len, bool const latch /*= true*/)
+{
+	if(shiftout == nullptr)
+		hw::panic();
+	if(busy())
+		return false;
+	//The push could finish (and call shiftout_complete) before latch_pending is set otherwise
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		if(!shiftout->push_buffer(buf, len))
+			return false;
+		latch_pending = latch;
+	}
+	return true;
+}
+
+bool libmodule::userio::IC_74HC595::busy() const
+{
+	return shiftout != nullptr && shiftout->busy();
+}
+
 void libmodule::userio::IC_74HC595::latch_regs() const
 {
 	if(digiout_latch != nullptr) {
@@ -80,3 +114,19 @@ void libmodule::userio::IC_74HC595::set_digiout_drivers(utility::Output<bool> *c
 {
 	digiout_drivers = output;
 }
+
+void libmodule::userio::IC_74HC595::set_shiftout(ShiftOut *const shiftout)
+{
+	this->shiftout = shiftout;
+	//nullptr goes back to bit-banging
+	if(shiftout != nullptr)
+		shiftout->set_callbacks(this);
+}
+
+void libmodule::userio::IC_74HC595::shiftout_complete()
+{
+	if(latch_pending) {
+		latch_pending = false;
+		latch_regs();
+	}
+}
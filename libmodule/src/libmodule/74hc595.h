@@ -11,11 +11,32 @@
 
 namespace libmodule {
 	namespace userio {
+		//Hardware that shifts out bytes MSB first (e.g. SPI, or a USART in master SPI mode), implemented by the hardware library (see libmicavr::USARTSPI)
+		class ShiftOut {
+		public:
+			class Callbacks {
+			public:
+				//Called from the interrupt once the last byte has been shifted out
+				virtual void shiftout_complete() = 0;
+			};
+			//Starts shifting out len bytes from buf (buf[0] first) and returns straight away. Returns false if a push is already in progress.
+			//No copy of buf is made, so keep it intact until busy() is false.
+			virtual bool push_buffer(uint8_t const buf[], uint8_t const len) = 0;
+			virtual bool busy() const = 0;
+			virtual void set_callbacks(Callbacks *const callbacks) = 0;
+		};
+
 		//Currently only supports output
-		class IC_74HC595 {
+		//If a ShiftOut is set, bytes are shifted out by it instead of bit-banging the data and clk outputs
+		class IC_74HC595 : public ShiftOut::Callbacks {
 		public:
 			//Pushes a buffer
+			//With a ShiftOut this waits for the push to finish, so don't call it with interrupts disabled
 			void push_buffer(void const *const ptr, size_t const len) const;
+			//Starts pushing len bytes to a chain of registers (buf[0] ends up in the last register) and returns straight away, the registers are latched from the interrupt when it finishes if latch is true
+			//Requires a ShiftOut. Returns false if the previous push hasn't finished. No copy of buf is made, so keep it intact until busy() is false.
+			bool push_chain(uint8_t const buf[], uint8_t const len, bool const latch = true);
+			bool busy() const;
 
 			//Makes sequential calls to push_data<uint8_t>
 			template <typename T>
@@ -33,7 +54,13 @@ namespace libmodule {
 			void set_digiout_clk(utility::Output<bool> *const output);
 			void set_digiout_latch(utility::Output<bool> *const output);
 			void set_digiout_drivers(utility::Output<bool> *const output);
+			//Set to nullptr to bit-bang with the data and clk outputs
+			void set_shiftout(ShiftOut *const shiftout);
 		private:
+			void shiftout_complete() override;
+
+			ShiftOut *shiftout = nullptr;
+			volatile bool latch_pending = false;
 			utility::Output<bool> *digiout_data = nullptr;
 			utility::Output<bool> *digiout_clk = nullptr;
 			utility::Output<bool> *digiout_latch = nullptr;
@@ -45,7 +72,7 @@ namespace libmodule {
 		//Writes one bit to the 74HC595
 		template <>
 		void IC_74HC595::push_data<bool>(bool const data) const;
-		//Bit-bangs data onto the 74HC595, MSB first
+		//Bit-bangs data onto the 74HC595, MSB first (or uses the ShiftOut if there is one)
 		template <>
 		void IC_74HC595::push_data<uint8_t>(uint8_t const data) const;
 	}
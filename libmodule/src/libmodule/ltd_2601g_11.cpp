@@ -6,16 +6,35 @@
  */ 
 
 #include "ltd_2601g_11.h"
+#include <string.h>
 #include <util/delay.h>
 #include <util/atomic.h>
 
 void libmodule::userio::IC_LTD_2601G_11::set_font(ic_ldt_2601g_11_fontdata::Font const font)
 {
 	this->font = font;
+	lastwrite.len = 0;
+}
+
+void libmodule::userio::IC_LTD_2601G_11::set_digit_brightness(uint8_t const pos, uint8_t const brightness) {}
+
+void libmodule::userio::IC_LTD_2601G_11::set_brightness(uint8_t const brightness)
+{
+	set_digit_brightness(0, brightness);
+	set_digit_brightness(1, brightness);
 }
 
 void libmodule::userio::IC_LTD_2601G_11::write_characters(char const str[], uint8_t const len /*= 2*/, uint8_t const dp_flags /*= 0*/)
 {
+	//Most frames write the same thing again, so skip rendering if nothing has changed
+	if(lastwrite.len != 0 && len == lastwrite.len && dp_flags == lastwrite.dp_flags && memcmp(str, lastwrite.str, len) == 0) return;
+	if(len <= sizeof lastwrite.str) {
+		memcpy(lastwrite.str, str, len);
+		lastwrite.len = len;
+		lastwrite.dp_flags = dp_flags;
+	}
+	else lastwrite.len = 0;
+
 	//Work on a copy to prevent race conditions (if implementation uses interrupts, for example)
 	uint8_t localdigitdata[2];
 	//If overwrite_dps is true, fully clear segments
@@ -58,6 +77,7 @@ void libmodule::userio::IC_LTD_2601G_11::clear()
 {
 	digitdata[0] = 0xff;
 	digitdata[1] = 0xff;
+	lastwrite.len = 0;
 }
 
 libmodule::utility::Output<bool> * libmodule::userio::IC_LTD_2601G_11::get_output_dp_left()
@@ -74,28 +94,173 @@ libmodule::userio::IC_LTD_2601G_11::IC_LTD_2601G_11() : output_dp_left(this, 0),
 
 uint8_t libmodule::userio::IC_LTD_2601G_11::find_digit(char const c) const
 {
-	for(uint8_t i = 0; i < font.len; i++) {
-		ic_ldt_2601g_11_fontdata::SerialDigit digit;
-		memcpy_P(&digit, font.pgm_character + i, sizeof(ic_ldt_2601g_11_fontdata::SerialDigit));
-		if(digit.key == c) return digit.data;
-	}
-	//If nothing is found, leave digit off
-	return 0;
+	//If there is no font or the character isn't ASCII, leave digit off
+	if(font.pgm_ascii == nullptr || static_cast<uint8_t>(c) >= ic_ldt_2601g_11_fontdata::ascii_len) return 0;
+	return pgm_read_byte(font.pgm_ascii + static_cast<uint8_t>(c));
 }
 
-libmodule::userio::ic_ldt_2601g_11_fontdata::Font libmodule::userio::ic_ldt_2601g_11_fontdata::decimal_font = {&(decimal_serial::pgm_arr[0]), decimal_len};
+libmodule::userio::ic_ldt_2601g_11_fontdata::Font libmodule::userio::ic_ldt_2601g_11_fontdata::decimal_font = {&(decimal_ascii::pgm_arr[0])};
 
 void libmodule::userio::IC_LTD_2601G_11::DPOut::set(bool const p)
 {
 	if(p) parent->digitdata[digit] &= ~(1 << 7);
 	else parent->digitdata[digit] |= 1 << 7;
+	//Next write_characters may need to put a decimal point from str back
+	parent->lastwrite.len = 0;
 }
 
 libmodule::userio::IC_LTD_2601G_11::DPOut::DPOut(IC_LTD_2601G_11 *const parent, uint8_t const digit) : parent(parent), digit(digit) {}
 
+void libmodule::userio::format_fixed(char str[], uint8_t const len, int16_t const value, uint8_t const sig10 /*= 1*/)
+{
+	if(len == 0) return;
+	//Doesn't fit in buf
+	if(sig10 > 4) {
+		str[0] = '\0';
+		return;
+	}
+	//Longest is "-3.2768" or "-32768"
+	char buf[8];
+	uint8_t pos = sizeof buf;
+	uint16_t magnitude = value < 0 ? -static_cast<int32_t>(value) : value;
+	//Digits are written from the right, and there is always at least one before the decimal point
+	for(uint8_t i = 0; i <= sig10 || magnitude > 0; i++) {
+		buf[--pos] = '0' + magnitude % 10;
+		magnitude /= 10;
+		if(i + 1 == sig10) buf[--pos] = '.';
+	}
+	if(value < 0) buf[--pos] = '-';
+	//Minimum width of 2
+	if(sizeof buf - pos < 2) buf[--pos] = ' ';
+	uint8_t const count = utility::tmin<uint8_t>(sizeof buf - pos, len - 1);
+	memcpy(str, buf + pos, count);
+	str[count] = '\0';
+}
+
+namespace {
+	//Index of the character after the digit starting at pos (a character followed by a decimal point is one digit)
+	uint8_t next_digit(char const str[], uint8_t const len, uint8_t const pos)
+	{
+		if(pos + 1 < len && str[pos] != '.' && str[pos + 1] == '.') return pos + 2;
+		return pos + 1;
+	}
+	//Index of the digit shown on the left once the string has scrolled to its end (0 if it fits on the display)
+	uint8_t last_frame(char const str[], uint8_t const len)
+	{
+		uint8_t pos = 0;
+		for(uint8_t next = next_digit(str, len, pos); next_digit(str, len, next) < len; next = next_digit(str, len, pos))
+			pos = next;
+		return pos;
+	}
+}
+
+void libmodule::userio::ScrollingText::update()
+{
+	if(display == nullptr || !timer) return;
+	//The front string has been fully shown, so move onto the next one
+	if(scrollpos >= str_len) {
+		scrollpos = 0;
+		//When repeating, the front is copied to the back (if the queue is full, that is the same entry)
+		if(repeat) queue[(queue_pos + queue_count) % queue_len] = queue[queue_pos];
+		else queue_count--;
+		queue_pos = (queue_pos + 1) % queue_len;
+	}
+	if(queue_count == 0) return;
+
+	Entry const &entry = queue[queue_pos];
+	uint8_t const len = strlen(entry.str);
+	//write_characters only uses as much of the string as fits
+	display->write_characters(entry.str + scrollpos, len - scrollpos, dp_flags);
+	uint8_t const next = next_digit(entry.str, len, scrollpos);
+	//Scroll if there is more after the two digits being shown
+	if(next_digit(entry.str, len, next) < len) {
+		scrollpos = next;
+		timer = scrollinterval;
+	}
+	else {
+		scrollpos = str_len;
+		timer = entry.ticks_hold;
+	}
+	timer.start();
+}
+
+bool libmodule::userio::ScrollingText::push(char const str[], uint16_t const ticks_hold)
+{
+	if(queue_count >= queue_len) return false;
+	Entry &entry = queue[(queue_pos + queue_count) % queue_len];
+	strncpy(entry.str, str, sizeof entry.str - 1);
+	entry.str[sizeof entry.str - 1] = '\0';
+	entry.ticks_hold = ticks_hold;
+	queue_count++;
+	return true;
+}
+
+void libmodule::userio::ScrollingText::set_front(char const str[])
+{
+	if(queue_count == 0) return;
+	Entry &entry = queue[queue_pos];
+	if(strncmp(entry.str, str, sizeof entry.str - 1) == 0) return;
+	strncpy(entry.str, str, sizeof entry.str - 1);
+	entry.str[sizeof entry.str - 1] = '\0';
+	uint8_t const len = strlen(entry.str);
+	uint8_t const last = last_frame(entry.str, len);
+	//Being held on the last frame (the hold time carries on)
+	if(scrollpos >= str_len) {
+		if(display != nullptr)
+			display->write_characters(entry.str + last, len - last, dp_flags);
+	}
+	//The new string may be shorter, so don't scroll past its last frame
+	else if(scrollpos > last)
+		scrollpos = last;
+}
+
+void libmodule::userio::ScrollingText::clear()
+{
+	queue_count = 0;
+	scrollpos = 0;
+	//So that the next string pushed is shown straight away
+	timer.stop();
+	timer.finished = true;
+}
+
+bool libmodule::userio::ScrollingText::finished() const
+{
+	return queue_count == 0;
+}
+
+uint8_t libmodule::userio::ScrollingText::count() const
+{
+	return queue_count;
+}
+
+void libmodule::userio::ScrollingText::set_display(IC_LTD_2601G_11 *const display)
+{
+	this->display = display;
+}
+
+void libmodule::userio::ScrollingText::set_scrollinterval(uint16_t const interval)
+{
+	scrollinterval = interval;
+}
+
+void libmodule::userio::ScrollingText::set_repeat(bool const repeat)
+{
+	this->repeat = repeat;
+}
+
+void libmodule::userio::ScrollingText::set_dp_flags(uint8_t const dp_flags)
+{
+	this->dp_flags = dp_flags;
+}
+
+libmodule::userio::ScrollingText::ScrollingText(IC_LTD_2601G_11 *const display /*= nullptr*/) : display(display)
+{
+	timer.finished = true;
+}
+
 void libmodule::userio::IC_LTD_2601G_11_74HC595::update()
 {
-	if(ic_shiftreg == nullptr || font.len == 0) return;
+	if(ic_shiftreg == nullptr || font.pgm_ascii == nullptr) return;
 	if(timer) {
 		timer = refreshinterval;
 		timer.start();
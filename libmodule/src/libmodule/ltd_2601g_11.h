@@ -25,13 +25,11 @@ namespace libmodule {
 				bool e : 1, c : 1;
 				bool d : 1, dp : 1;
 			};
-			struct SerialDigit {
-				char key;
-				uint8_t data;
-			};
+			//Font tables have an entry for every ASCII character (characters not in the font are 0, so off)
+			constexpr size_t ascii_len = 128;
 			struct Font {
-				SerialDigit const *pgm_character = nullptr;
-				uint8_t len = 0;
+				//Segment data indexed by ASCII value, in PROGMEM
+				uint8_t const *pgm_ascii = nullptr;
 			};
 		}
 
@@ -51,9 +49,15 @@ namespace libmodule {
 			//str can have decimal points (hence size of 4)
 			//If 'overwrite_flags' is true for a decimal point, the decimal point can be manually entered using dp_flags, respectively.
 			//str[0] corresponds to the character on the left
+			//If str, len and dp_flags are the same as the last call (and nothing else has changed the display since), nothing is done
 			void write_characters(char const str[], uint8_t const len = 2, uint8_t const dp_flags = 0);
 			//Clears the display
 			void clear();
+			//Sets the brightness of the digit at pos (0 is left), from 0 (off) to 255 (full brightness)
+			//Unless an inherited class overrides this function, it does nothing (the display is always at full brightness)
+			virtual void set_digit_brightness(uint8_t const pos, uint8_t const brightness);
+			//Sets the brightness of both digits
+			void set_brightness(uint8_t const brightness);
 
 			utility::Output<bool> *get_output_dp_left();
 			utility::Output<bool> *get_output_dp_right();
@@ -70,10 +74,67 @@ namespace libmodule {
 			
 			ic_ldt_2601g_11_fontdata::Font font;
 			uint8_t digitdata[2] = {0xff, 0xff};
+			//Arguments of the last write_characters call, len is 0 if the display has changed since
+			struct {
+				char str[4];
+				uint8_t len = 0;
+				uint8_t dp_flags;
+			} lastwrite;
 			
 			uint8_t find_digit(char const c) const;
 		};
 
+		//Prints value / 10^sig10 the same as snprintf with "%2.<sig10>f" would (e.g. 123 with sig10 = 1 is "12.3"), but without needing floating point printf
+		//Like snprintf, the string is cut off to fit in len (including the '\0'). sig10 can be up to 4 (str is left empty otherwise).
+		void format_fixed(char str[], uint8_t const len, int16_t const value, uint8_t const sig10 = 1);
+
+		//Shows a queue of strings one after the other on an IC_LTD_2601G_11. Strings that don't fit on the display are scrolled one digit at a time.
+		//Each frame is shown until a timer finishes (nothing waits), so update() needs to be called regularly.
+		class ScrollingText {
+		public:
+			static constexpr uint8_t queue_len = 4;
+			//Longest string (including the '\0')
+			static constexpr uint8_t str_len = 8;
+
+			void update();
+			//Adds str to the end of the queue (cut off at str_len - 1 characters). Returns false if the queue is full.
+			//If str fits on the display it is shown for ticks_hold. Otherwise it scrolls every scroll interval, and the last two digits are shown for ticks_hold.
+			bool push(char const str[], uint16_t const ticks_hold);
+			//Replaces the string at the front of the queue (keeping its ticks_hold), e.g. to show a value that is changing. Does nothing if the queue is empty.
+			//If the front string is on its last frame it is redrawn straight away, otherwise the new string is used from the next scroll step.
+			void set_front(char const str[]);
+			//Empties the queue. What is currently shown stays on the display.
+			void clear();
+			//True when everything in the queue has been shown
+			bool finished() const;
+			//Number of strings in the queue, including the one being shown
+			uint8_t count() const;
+
+			void set_display(IC_LTD_2601G_11 *const display);
+			void set_scrollinterval(uint16_t const interval);
+			//If true, strings are added back to the end of the queue once they have been shown (so the queue repeats until cleared)
+			void set_repeat(bool const repeat);
+			//Passed to IC_LTD_2601G_11::write_characters. By default the decimal points come only from the strings.
+			void set_dp_flags(uint8_t const dp_flags);
+
+			ScrollingText(IC_LTD_2601G_11 *const display = nullptr);
+		private:
+			IC_LTD_2601G_11 *display;
+			struct Entry {
+				char str[str_len];
+				uint16_t ticks_hold;
+			} queue[queue_len];
+			//Index of the front of the queue
+			uint8_t queue_pos = 0;
+			uint8_t queue_count = 0;
+			//Position in the front string of the next digit to show on the left, str_len once the string has been fully shown
+			uint8_t scrollpos = 0;
+			uint16_t scrollinterval = 300;
+			uint8_t dp_flags = IC_LTD_2601G_11::OVERWRITE_LEFT | IC_LTD_2601G_11::OVERWRITE_RIGHT;
+			bool repeat = false;
+			Timer1k timer;
+		};
+
 		class IC_LTD_2601G_11_74HC595 : public IC_LTD_2601G_11 {
 		public:
 			void update();
@@ -145,17 +206,35 @@ namespace libmodule {
 			};
 			constexpr size_t decimal_len = sizeof decimal_const / sizeof(ConstDigit);
 			
-			constexpr SerialDigit conv_constdigit_to_serialdigit(ConstDigit const p) {
-				return {p.key, static_cast<uint8_t>(p.a << 0 | p.b << 1 | p.c << 2 | p.d << 3 | p.e << 4 | p.f << 5 | p.g << 6 | p.dp << 7)};
+			constexpr uint8_t conv_constdigit_to_segments(ConstDigit const p) {
+				return p.a << 0 | p.b << 1 | p.c << 2 | p.d << 3 | p.e << 4 | p.f << 5 | p.g << 6 | p.dp << 7;
 			}
+			//Segment data for c in digits (0 if c isn't in digits)
+			template <size_t len_c>
+			constexpr uint8_t conv_constdigits_to_ascii(ConstDigit const (&digits)[len_c], char const c) {
+				for(size_t i = 0; i < len_c; i++) {
+					if(digits[i].key == c) return conv_constdigit_to_segments(digits[i]);
+				}
+				return 0;
+			}
+
+			//Gives seq_t<0, 1, ..., count_c - 1> as type (used to make the ascii_len entry font tables)
+			template <template <size_t ...> class seq_t, size_t count_c = ascii_len, size_t ...seq>
+			struct make_sequence {
+				using type = typename make_sequence<seq_t, count_c - 1, count_c - 1, seq...>::type;
+			};
+			template <template <size_t ...> class seq_t, size_t ...seq>
+			struct make_sequence<seq_t, 0, seq...> {
+				using type = seq_t<seq...>;
+			};
 
 			template <size_t ...seq>
-			struct decimal_serial_t {
-				static SerialDigit const pgm_arr[sizeof...(seq)];
+			struct decimal_ascii_t {
+				static uint8_t const pgm_arr[sizeof...(seq)];
 			};
 			template <size_t ...seq>
-			SerialDigit const decimal_serial_t<seq...>::pgm_arr[] PROGMEM = {conv_constdigit_to_serialdigit(decimal_const[seq])...};
-			using decimal_serial = decimal_serial_t<0, 1, 2, 3, 4, 5, 6, 7, 8, 9>;			
+			uint8_t const decimal_ascii_t<seq...>::pgm_arr[] PROGMEM = {conv_constdigits_to_ascii(decimal_const, seq)...};
+			using decimal_ascii = make_sequence<decimal_ascii_t>::type;
 			extern Font decimal_font;
 		}
 	}
@@ -16,29 +16,144 @@
 0x04-0x0B: Name
 0x0C: Status
 0x0D: Settings
-0x0E: InstanceCount
-0x0F: SampleCount
-0x10-0x13: RPS
-0x14-0x17: TPS
-0x18: SamplePos
-0x19...: SampleBuffer
+0x0E-0x0F: SyncOffset
+0x10-0x11: SyncTime
+0x12: SyncAdjust
+0x13: InstanceCount
+0x14: SampleCount
+0x15-0x18: RPS
+0x19-0x1C: TPS
+0x1D: SamplePos
+0x1E...: SampleBuffer
+...: StreamCount
+...: StreamLost
+...: StreamBuffer
 */
 
 namespace libmodule {
 	namespace module {
 		namespace metadata {
+			//Register layout schema
+			//Each module layout is declared once, as a list of fields (in buffer order) with their sizes and how the master accesses them
+			//The offset enums that the modules use are generated from it, and so are the master register descriptors (see rt::twi::RegisterTable in TestMaster)
+			namespace schema {
+				//How the master accesses a field
+				namespace access {
+					enum e : uint8_t {
+						//Read when the register table is started (see rt::twi::MasterBufferManager::run), or when requested
+						Read = 0,
+						//Written when the master changes it
+						Write = 1 << 0,
+						//Read or written every cycle
+						Regular = 1 << 1,
+						//Read or written in the next cycle, even if the register table has already been started
+						Next = 1 << 2,
+						//Part of the register of the previous field (which has the access of its first field)
+						Join = 1 << 3,
+						//Not read or written through the register table
+						None = 1 << 4,
+					};
+				}
+				//Same order as rt::twi::RegisterDesc::Priority
+				enum Priority : uint8_t {
+					Low = 0,
+					Normal,
+					High,
+				};
+				struct Field {
+					//Size in bytes. 0 is used for a field that is sized at runtime (e.g. sample buffers), which has to be the last field of a layout.
+					uint16_t size;
+					uint8_t access = access::Read;
+					uint8_t priority = Normal;
+					//Time (in ms) from the start of a master cycle that the field should be done by, 0 for no deadline
+					uint8_t deadline = 0;
+				};
+				struct Layout {
+					Field const *fields;
+					uint8_t count;
+					//Offset of the first field
+					uint16_t base;
+				};
+				//Offset of fields[index] (index == count gives the end of the layout)
+				constexpr uint16_t offset(Layout const &layout, uint8_t const index) {
+					uint16_t pos = layout.base;
+					for(uint8_t i = 0; i < index; i++)
+						pos += layout.fields[i].size;
+					return pos;
+				}
+				constexpr uint16_t end(Layout const &layout) {
+					return offset(layout, layout.count);
+				}
+				//Number of master registers (fields that are not joined to the previous field or skipped)
+				constexpr uint8_t regcount(Layout const &layout) {
+					uint8_t count = 0;
+					for(uint8_t i = 0; i < layout.count; i++) {
+						if(!(layout.fields[i].access & (access::Join | access::None)))
+							count++;
+					}
+					return count;
+				}
+				//Whether every Join field follows a field that has a register (or is joined to one), which RegisterTable relies on
+				constexpr bool joins_valid(Layout const &layout) {
+					for(uint8_t i = 0; i < layout.count; i++) {
+						if((layout.fields[i].access & access::Join) && (i == 0 || (layout.fields[i - 1].access & access::None)))
+							return false;
+					}
+					return true;
+				}
+			}
+
 			namespace com {
 				constexpr size_t NameLength = 8;
 				extern uint8_t Header[2];//; //Sort of "SEMA"
-				namespace offset {
+				//Module time in ms, same as the master time once synced
+				using ms_t = uint16_t;
+				namespace field {
 					enum e {
 						Header = 0,
-						Signature = Header + sizeof com::Header,
+						Signature,
 						ID,
 						Name,
-						Status = Name + NameLength,
+						Status,
 						Settings,
-						_size,
+						//Fields added after Settings, so that the fields before them stay where they were
+						//Master time minus module time (set by the module when SyncTime is written)
+						SyncOffset,
+						//Written by the master using a general call, so that every module gets it at the same time
+						SyncTime,
+						//Written by the master after SyncTime, with how many ms late SyncTime was when it was sent (added to SyncOffset)
+						SyncAdjust,
+						_count,
+					};
+				}
+				constexpr schema::Field Fields[] = {
+					//size, access, [priority, deadline]
+					{sizeof com::Header, schema::access::Read, schema::Low},
+					{1, schema::access::Join},
+					{1, schema::access::Join},
+					{NameLength, schema::access::Join},
+					{1, schema::access::Regular},
+					{1, schema::access::Write},
+					{sizeof(ms_t), schema::access::Next, schema::Low},
+					//SyncTime and SyncAdjust are only written by rt::module::TimeSync
+					{sizeof(ms_t), schema::access::None},
+					{1, schema::access::None},
+				};
+				static_assert(sizeof Fields / sizeof(schema::Field) == field::_count, "com::Fields does not match com::field");
+				constexpr schema::Layout Layout{Fields, field::_count, 0};
+				static_assert(schema::joins_valid(Layout), "com::Fields has a Join that does not follow a register");
+				namespace offset {
+					enum e {
+						Header = schema::offset(Layout, field::Header),
+						Signature = schema::offset(Layout, field::Signature),
+						ID = schema::offset(Layout, field::ID),
+						Name = schema::offset(Layout, field::Name),
+						Status = schema::offset(Layout, field::Status),
+						Settings = schema::offset(Layout, field::Settings),
+						SyncOffset = schema::offset(Layout, field::SyncOffset),
+						SyncTime = schema::offset(Layout, field::SyncTime),
+						SyncAdjust = schema::offset(Layout, field::SyncAdjust),
+						_size = schema::end(Layout),
 					};
 				}
 				namespace sig {
@@ -68,26 +183,113 @@ namespace libmodule {
 			namespace speedmonitor {
 				using rps_t = uint32_t;
 				using cps_t = uint32_t;
-				namespace offset {
+				namespace field {
 					namespace manager {
 						enum e {
-							InstanceCount = com::offset::_size,
+							InstanceCount = 0,
 							SampleCount,
-							_size,
+							_count,
 						};
 					}
-					namespace instance {
+					namespace constants {
 						enum e {
-							Constant_RPS = 0,
-							Constant_TPS = Constant_RPS + sizeof(rps_t),
-							SamplePos = Constant_TPS + sizeof(cps_t),
+							RPS = 0,
+							TPS,
+							_count,
+						};
+					}
+					namespace samples {
+						enum e {
+							SamplePos = 0,
 							SampleBuffer,
+							_count,
+						};
+					}
+					//Reading from Count drains the samples that were read from the FIFO
+					namespace stream {
+						enum e {
+							//Number of samples waiting in Buffer
+							Count = 0,
+							//Number of samples dropped because the FIFO was full since it was last read (saturates at 0xff)
+							Lost,
+							//Samples oldest first
+							Buffer,
+							_count,
 						};
 					}
 				}
+				//Manager registers, after the common registers
+				constexpr schema::Field ManagerFields[] = {
+					{1, schema::access::Read},
+					{1, schema::access::Join},
+				};
+				static_assert(sizeof ManagerFields / sizeof(schema::Field) == field::manager::_count, "speedmonitor::ManagerFields does not match speedmonitor::field::manager");
+				constexpr schema::Layout ManagerLayout{ManagerFields, field::manager::_count, com::offset::_size};
+				static_assert(schema::joins_valid(ManagerLayout), "speedmonitor::ManagerFields has a Join that does not follow a register");
+				//Each instance is the constants, the samples and then the stream (FIFO drain) registers
+				//Instance layouts are relative to the start of the instance, and the stream layout is relative to stream_offset() (since it comes after SampleBuffer)
+				//Each entry in SampleBuffer and StreamBuffer is a sample, followed by a com::ms_t timestamp if the Timestamped status bit is set
+				constexpr schema::Field ConstantFields[] = {
+					//Next so that these are read when the number of instances is determined
+					{sizeof(rps_t), schema::access::Next, schema::Low},
+					{sizeof(cps_t), schema::access::Join},
+				};
+				static_assert(sizeof ConstantFields / sizeof(schema::Field) == field::constants::_count, "speedmonitor::ConstantFields does not match speedmonitor::field::constants");
+				constexpr schema::Layout ConstantLayout{ConstantFields, field::constants::_count, 0};
+				static_assert(schema::joins_valid(ConstantLayout), "speedmonitor::ConstantFields has a Join that does not follow a register");
+				constexpr schema::Field SampleFields[] = {
+					{1, schema::access::Regular},
+					//SampleCount entries
+					{0, schema::access::Regular},
+				};
+				static_assert(sizeof SampleFields / sizeof(schema::Field) == field::samples::_count, "speedmonitor::SampleFields does not match speedmonitor::field::samples");
+				constexpr schema::Layout SampleLayout{SampleFields, field::samples::_count, schema::end(ConstantLayout)};
+				static_assert(schema::joins_valid(SampleLayout), "speedmonitor::SampleFields has a Join that does not follow a register");
+				constexpr schema::Field StreamFields[] = {
+					{1, schema::access::Regular},
+					{1, schema::access::Join},
+					//SampleCount entries (the master only reads as many as it takes each cycle)
+					{0, schema::access::Join},
+				};
+				static_assert(sizeof StreamFields / sizeof(schema::Field) == field::stream::_count, "speedmonitor::StreamFields does not match speedmonitor::field::stream");
+				constexpr schema::Layout StreamLayout{StreamFields, field::stream::_count, 0};
+				static_assert(schema::joins_valid(StreamLayout), "speedmonitor::StreamFields has a Join that does not follow a register");
+				namespace offset {
+					namespace manager {
+						enum e {
+							InstanceCount = schema::offset(ManagerLayout, field::manager::InstanceCount),
+							SampleCount = schema::offset(ManagerLayout, field::manager::SampleCount),
+							_size = schema::end(ManagerLayout),
+						};
+					}
+					namespace instance {
+						enum e {
+							Constant_RPS = schema::offset(ConstantLayout, field::constants::RPS),
+							Constant_TPS = schema::offset(ConstantLayout, field::constants::TPS),
+							SamplePos = schema::offset(SampleLayout, field::samples::SamplePos),
+							SampleBuffer = schema::offset(SampleLayout, field::samples::SampleBuffer),
+						};
+					}
+					namespace stream {
+						enum e {
+							Count = schema::offset(StreamLayout, field::stream::Count),
+							Lost = schema::offset(StreamLayout, field::stream::Lost),
+							Buffer = schema::offset(StreamLayout, field::stream::Buffer),
+						};
+					}
+					//Instance offset of the stream registers
+					constexpr size_t stream_offset(size_t const samplecount, size_t const entrysize) {
+						return schema::end(SampleLayout) + samplecount * entrysize;
+					}
+					//Total size of an instance
+					constexpr size_t instance_size(size_t const samplecount, size_t const entrysize) {
+						return stream_offset(samplecount, entrysize) + schema::end(StreamLayout) + samplecount * entrysize;
+					}
+				}
 				namespace sig {
 					namespace status {
 						enum e {
+							Timestamped = 2,
 							SampleSize = 4,
 						};
 					}
@@ -101,16 +303,41 @@ namespace libmodule {
 				}
 			}
 			namespace motorcontroller {
-				namespace offset {
+				namespace field {
 					enum e {
-						Voltage_MaxCurrent = com::offset::_size,
-						PWM_MaxCurrent = Voltage_MaxCurrent + sizeof(uint16_t),
-						MeasuredCurrent = PWM_MaxCurrent + sizeof(uint16_t),
-						MeasuredVoltage = MeasuredCurrent + sizeof(uint16_t),
-						PWMFrequency = MeasuredVoltage + sizeof(uint16_t),
-						PWMDutyCycle = PWMFrequency + sizeof(uint16_t),
+						Voltage_MaxCurrent = 0,
+						PWM_MaxCurrent,
+						MeasuredCurrent,
+						MeasuredVoltage,
+						PWMFrequency,
+						PWMDutyCycle,
 						ControlVoltage,
-						_size,
+						_count,
+					};
+				}
+				constexpr schema::Field Fields[] = {
+					{sizeof(uint16_t), schema::access::Write},
+					{sizeof(uint16_t), schema::access::Join},
+					//Read first every cycle, needed to catch overcurrent
+					{sizeof(uint16_t), schema::access::Regular, schema::High, 10},
+					{sizeof(uint16_t), schema::access::Regular},
+					{sizeof(uint16_t), schema::access::Write},
+					{1, schema::access::Join},
+					{1, schema::access::Write},
+				};
+				static_assert(sizeof Fields / sizeof(schema::Field) == field::_count, "motorcontroller::Fields does not match motorcontroller::field");
+				constexpr schema::Layout Layout{Fields, field::_count, com::offset::_size};
+				static_assert(schema::joins_valid(Layout), "motorcontroller::Fields has a Join that does not follow a register");
+				namespace offset {
+					enum e {
+						Voltage_MaxCurrent = schema::offset(Layout, field::Voltage_MaxCurrent),
+						PWM_MaxCurrent = schema::offset(Layout, field::PWM_MaxCurrent),
+						MeasuredCurrent = schema::offset(Layout, field::MeasuredCurrent),
+						MeasuredVoltage = schema::offset(Layout, field::MeasuredVoltage),
+						PWMFrequency = schema::offset(Layout, field::PWMFrequency),
+						PWMDutyCycle = schema::offset(Layout, field::PWMDutyCycle),
+						ControlVoltage = schema::offset(Layout, field::ControlVoltage),
+						_size = schema::end(Layout),
 					};
 				}
 				namespace sig {
@@ -140,12 +367,29 @@ namespace libmodule {
 				}
 			}
 			namespace motormover {
+				namespace field {
+					enum e {
+						Position_Engaged = 0,
+						Position_Disengaged,
+						ContinuousPosition,
+						_count,
+					};
+				}
+				//The positions are set on the module itself, the master only uses the common registers
+				constexpr schema::Field Fields[] = {
+					{sizeof(uint16_t), schema::access::None},
+					{sizeof(uint16_t), schema::access::None},
+					{1, schema::access::None},
+				};
+				static_assert(sizeof Fields / sizeof(schema::Field) == field::_count, "motormover::Fields does not match motormover::field");
+				constexpr schema::Layout Layout{Fields, field::_count, com::offset::_size};
+				static_assert(schema::joins_valid(Layout), "motormover::Fields has a Join that does not follow a register");
 				namespace offset {
 					enum e {
-						Position_Engaged = com::offset::_size,
-						Position_Disengaged = Position_Engaged + sizeof(uint16_t),
-						ContinuousPosition = Position_Disengaged + sizeof(uint16_t),
-						_size,
+						Position_Engaged = schema::offset(Layout, field::Position_Engaged),
+						Position_Disengaged = schema::offset(Layout, field::Position_Disengaged),
+						ContinuousPosition = schema::offset(Layout, field::ContinuousPosition),
+						_size = schema::end(Layout),
 					};
 				}
 				namespace sig {
@@ -24,6 +24,21 @@ bool libmodule::module::Slave::connected() const
 	return buffermanager.connected();
 }
 
+void libmodule::module::Slave::set_timesync(bool const enable)
+{
+	buffermanager.set_generalcall(enable);
+}
+
+libmodule::module::metadata::com::ms_t libmodule::module::Slave::get_time() const
+{
+	metadata::com::ms_t time;
+	//Both are changed from interrupts
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		time = pm_clock.ticks + pm_syncoffset;
+	}
+	return time;
+}
+
 void libmodule::module::Slave::set_signature(uint8_t const signature)
 {
 	buffer.serialiseWrite(signature, metadata::com::offset::Signature);
@@ -54,7 +69,11 @@ bool libmodule::module::Slave::get_power()
 	return buffer.bit_get(metadata::com::offset::Settings, metadata::com::sig::settings::Power);
 }
 
-libmodule::module::Slave::Slave(twi::TWISlave &twislave, utility::Buffer &buffer) : buffer(buffer), buffermanager(twislave, buffer, metadata::com::Header, 1) {}
+libmodule::module::Slave::Slave(twi::TWISlave &twislave, utility::Buffer &buffer) : buffer(buffer), buffermanager(twislave, buffer, metadata::com::Header, 1)
+{
+	buffermanager.m_callbacks = this;
+	pm_clock.start();
+}
 
 void libmodule::module::Slave::write_header()
 {
@@ -62,6 +81,22 @@ void libmodule::module::Slave::write_header()
 
 void libmodule::module::Slave::write_constants() {}
 
+void libmodule::module::Slave::registers_sent(uint16_t const regaddr, uint8_t const data[], uint16_t const len) {}
+
+void libmodule::module::Slave::registers_received(uint16_t const regaddr, uint16_t const len)
+{
+	//Called from the TWI interrupt, so the clock is read as close as possible to when the master sent SyncTime
+	//SyncTime is only used if it was written in full
+	bool const synctime = regaddr <= metadata::com::offset::SyncTime && regaddr + len >= metadata::com::offset::SyncTime + sizeof(metadata::com::ms_t);
+	bool const syncadjust = regaddr <= metadata::com::offset::SyncAdjust && regaddr + len > metadata::com::offset::SyncAdjust;
+	if(synctime)
+		pm_syncoffset = buffer.serialiseRead<metadata::com::ms_t>(metadata::com::offset::SyncTime) - pm_clock.ticks;
+	if(syncadjust)
+		pm_syncoffset += buffer.serialiseRead<uint8_t>(metadata::com::offset::SyncAdjust);
+	if(synctime || syncadjust)
+		buffer.serialiseWrite(pm_syncoffset, metadata::com::offset::SyncOffset);
+}
+
 void libmodule::module::Slave::update()
 {
 	//If there is a change of connection, re-write all the constants
@@ -14,16 +14,20 @@
 
 namespace libmodule {
 	namespace module {
-		//Module format: {5E, 8A, sig, id, name[8], status, settings, ...}
+		//Module format: {5E, 8A, sig, id, name[8], status, syncoffset[2], settings, synctime[2], syncadjust, ...}
 		
 		//Handles communication/interpreting communication
-		class Slave  {
+		class Slave : public twi::SlaveBufferManager::Callbacks {
 		public:
 			void update();
 		
 			void set_timeout(size_t const timeout);
 			void set_twiaddr(uint8_t const addr);
 			bool connected() const;
+			//Accept time sync broadcasts from the master (TWI general call writes to SyncTime and SyncAdjust)
+			void set_timesync(bool const enable);
+			//Module time (ms), which is the master time once a time sync has been received
+			metadata::com::ms_t get_time() const;
 
 			void set_signature(uint8_t const signature);
 			void set_id(uint8_t const id);
@@ -43,6 +47,12 @@ namespace libmodule {
 
 			void write_header();
 			virtual void write_constants();
+			void registers_sent(uint16_t const regaddr, uint8_t const data[], uint16_t const len) override;
+		private:
+			Stopwatch1k pm_clock;
+			metadata::com::ms_t pm_syncoffset = 0;
+
+			void registers_received(uint16_t const regaddr, uint16_t const len) override;
 		};
 
 		class Horn : public Slave {
@@ -53,37 +63,54 @@ namespace libmodule {
 			utility::StaticBuffer<metadata::com::offset::_size> buffer;
 		};
 
-		template <size_t len_c, typename sample_t = uint32_t>
+		//If timestamp_c is true, each sample is stored with the module time (see Slave::get_time) at which it was pushed
+		template <size_t len_c, typename sample_t = uint32_t, bool timestamp_c = false>
 		class SpeedMonitor {
 			static_assert(len_c > 0, "SpeedMonitor len must be greater than 0");
+			static_assert(len_c <= 0xff, "SpeedMonitor len must fit in the SampleCount register");
 			static_assert(sizeof(sample_t) <= 0xf, "SpeedMonitor sample_t must have size less than 0xf");
 
 			template <typename, size_t>
 			friend class SpeedMonitorManager;
 		public:
 			static constexpr size_t sample_count = len_c;
+			static constexpr bool timestamped = timestamp_c;
+			//Size of a sample and its timestamp in the buffer
+			static constexpr size_t entry_size = sizeof(sample_t) + (timestamp_c ? sizeof(metadata::com::ms_t) : 0);
 			void set_rps_constant(metadata::speedmonitor::rps_t const rps);
 			void set_tps_constant(metadata::speedmonitor::cps_t const tps);
 
+			//Writes the sample to the circular buffer and adds it to the stream FIFO (if the FIFO is full the oldest sample is dropped)
 			void push_sample(sample_t const sample);
 			sample_t get_sample(uint8_t const pos);
+			//Returns 0 if timestamp_c is false
+			metadata::com::ms_t get_sample_time(uint8_t const pos);
 			void clear_samples();
 		private:
+			static constexpr size_t stream_offset_c = metadata::speedmonitor::offset::stream_offset(len_c, entry_size);
 			utility::Buffer buffer;
+			//Set by SpeedMonitorManager, used for the time of timestamps
+			Slave const *pm_slave = nullptr;
 			uint8_t pm_samplepos = 0;
 			//These are held so that the constants can be re-written when "wrote_constants" is called in master
 			metadata::speedmonitor::rps_t pm_rps = 0;
 			metadata::speedmonitor::cps_t pm_tps = 0;
 
 			void write_constants();
+			//Called from the TWI interrupt when the master has read len bytes (data) starting at regaddr (relative to the instance)
+			void registers_sent(uint16_t const regaddr, uint8_t const data[], uint16_t const len);
+			//Removes count samples from the front of the stream FIFO
+			void stream_pop(uint8_t const count);
+			//Writes a sample (and timestamp) at pos in the buffer
+			void write_entry(size_t const pos, sample_t const sample, metadata::com::ms_t const time);
 		};
 
 		template <typename>
 		struct speedmonitor_len;
 
 		//Used to determine len_c and sample_t of a SpeedMonitor
-		template <size_t len, typename tsample>
-		struct speedmonitor_len<SpeedMonitor<len, tsample>> {
+		template <size_t len, typename tsample, bool timestamp>
+		struct speedmonitor_len<SpeedMonitor<len, tsample, timestamp>> {
 			static constexpr size_t len_c = len;
 			using sample_t = tsample;
 		};
@@ -96,9 +123,10 @@ namespace libmodule {
 			using speedmonitor_len_t = speedmonitor_len<SpeedMonitor_t>;
 			using sample_t = typename speedmonitor_len_t::sample_t;
 			static constexpr size_t len_c = speedmonitor_len_t::len_c;
-			static constexpr size_t instance_buffer_size_c = metadata::speedmonitor::offset::instance::SampleBuffer + len_c * sizeof(sample_t);
+			static constexpr size_t instance_buffer_size_c = metadata::speedmonitor::offset::instance_size(len_c, SpeedMonitor_t::entry_size);
 			static constexpr size_t manager_buffer_size_c = metadata::speedmonitor::offset::manager::_size;
 			static constexpr size_t overall_buffer_size_c = manager_buffer_size_c + count_c * instance_buffer_size_c;
+			static_assert(overall_buffer_size_c <= twi::addressing::WideMax, "SpeedMonitorManager buffer is too large to be addressed");
 		public:
 			static constexpr size_t monitor_count = count_c;
 			void register_speedMonitor(uint8_t const pos, SpeedMonitor_t *const instance);
@@ -109,6 +137,7 @@ namespace libmodule {
 			SpeedMonitor_t *pm_monitors[count_c];
 			
 			void write_constants() override;
+			void registers_sent(uint16_t const regaddr, uint8_t const data[], uint16_t const len) override;
 		};
 
 		class MotorController : public Slave {
@@ -213,64 +242,125 @@ namespace libmodule {
 }
 
 
-template <size_t len_c, typename sample_t /*= uint32_t*/>
-void libmodule::module::SpeedMonitor<len_c, sample_t>::set_rps_constant(metadata::speedmonitor::rps_t const rps)
+template <size_t len_c, typename sample_t /*= uint32_t*/, bool timestamp_c /*= false*/>
+void libmodule::module::SpeedMonitor<len_c, sample_t, timestamp_c>::set_rps_constant(metadata::speedmonitor::rps_t const rps)
 {
 	buffer.serialiseWrite(rps, metadata::speedmonitor::offset::instance::Constant_RPS);
 	pm_rps = rps;
 }
 
 
-template <size_t len_c, typename sample_t /*= uint32_t*/>
-void libmodule::module::SpeedMonitor<len_c, sample_t>::set_tps_constant(metadata::speedmonitor::rps_t const tps)
+template <size_t len_c, typename sample_t /*= uint32_t*/, bool timestamp_c /*= false*/>
+void libmodule::module::SpeedMonitor<len_c, sample_t, timestamp_c>::set_tps_constant(metadata::speedmonitor::rps_t const tps)
 {
 	buffer.serialiseWrite(tps, metadata::speedmonitor::offset::instance::Constant_TPS);
 	pm_tps = tps;
 }
 
 
-template <size_t len_c, typename sample_t /*= uint32_t*/>
-void libmodule::module::SpeedMonitor<len_c, sample_t>::push_sample(sample_t const sample)
+template <size_t len_c, typename sample_t /*= uint32_t*/, bool timestamp_c /*= false*/>
+void libmodule::module::SpeedMonitor<len_c, sample_t, timestamp_c>::push_sample(sample_t const sample)
 {
-	buffer.serialiseWrite(sample, metadata::speedmonitor::offset::instance::SampleBuffer + pm_samplepos * sizeof(sample_t));
+	metadata::com::ms_t const time = (timestamp_c && pm_slave != nullptr) ? pm_slave->get_time() : 0;
+	write_entry(metadata::speedmonitor::offset::instance::SampleBuffer + pm_samplepos * entry_size, sample, time);
 	buffer.serialiseWrite(pm_samplepos, metadata::speedmonitor::offset::instance::SamplePos);
 	if(++pm_samplepos >= len_c) {
 		pm_samplepos = 0;
 	}
+	//The master may be draining the FIFO from the interrupt
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		uint8_t count = buffer.pm_ptr[stream_offset_c + metadata::speedmonitor::offset::stream::Count];
+		if(count >= len_c) {
+			stream_pop(1);
+			count--;
+			uint8_t &lost = buffer.pm_ptr[stream_offset_c + metadata::speedmonitor::offset::stream::Lost];
+			if(lost < 0xff)
+				lost++;
+		}
+		write_entry(stream_offset_c + metadata::speedmonitor::offset::stream::Buffer + count * entry_size, sample, time);
+		buffer.pm_ptr[stream_offset_c + metadata::speedmonitor::offset::stream::Count] = count + 1;
+	}
 }
 
 
-template <size_t len_c, typename sample_t /*= uint32_t*/>
-sample_t libmodule::module::SpeedMonitor<len_c, sample_t>::get_sample(uint8_t const pos)
+template <size_t len_c, typename sample_t /*= uint32_t*/, bool timestamp_c /*= false*/>
+sample_t libmodule::module::SpeedMonitor<len_c, sample_t, timestamp_c>::get_sample(uint8_t const pos)
 {
 	if(pos >= len_c)
 		return 0;
-	return buffer.serialiseRead<sample_t>(metadata::speedmonitor::offset::instance::SampleBuffer + pos * sizeof(sample_t));
+	return buffer.serialiseRead<sample_t>(metadata::speedmonitor::offset::instance::SampleBuffer + pos * entry_size);
 }
 
-template <size_t len_c, typename sample_t /*= uint32_t*/>
-void libmodule::module::SpeedMonitor<len_c, sample_t>::clear_samples()
+template <size_t len_c, typename sample_t /*= uint32_t*/, bool timestamp_c /*= false*/>
+libmodule::module::metadata::com::ms_t libmodule::module::SpeedMonitor<len_c, sample_t, timestamp_c>::get_sample_time(uint8_t const pos)
 {
-	memset(buffer.pm_ptr + metadata::speedmonitor::offset::instance::SampleBuffer, 0, len_c * sizeof(sample_t));
+	if(!timestamp_c || pos >= len_c)
+		return 0;
+	return buffer.serialiseRead<metadata::com::ms_t>(metadata::speedmonitor::offset::instance::SampleBuffer + pos * entry_size + sizeof(sample_t));
+}
+
+template <size_t len_c, typename sample_t /*= uint32_t*/, bool timestamp_c /*= false*/>
+void libmodule::module::SpeedMonitor<len_c, sample_t, timestamp_c>::clear_samples()
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		memset(buffer.pm_ptr + metadata::speedmonitor::offset::instance::SampleBuffer, 0, buffer.pm_len - metadata::speedmonitor::offset::instance::SampleBuffer);
+	}
 	pm_samplepos = 0;
 }
 
-template <size_t len_c, typename sample_t /*= uint32_t*/>
-void libmodule::module::SpeedMonitor<len_c, sample_t>::write_constants()
+template <size_t len_c, typename sample_t /*= uint32_t*/, bool timestamp_c /*= false*/>
+void libmodule::module::SpeedMonitor<len_c, sample_t, timestamp_c>::write_constants()
 {
 	set_rps_constant(pm_rps);
 	set_tps_constant(pm_tps);
 }
 
+template <size_t len_c, typename sample_t /*= uint32_t*/, bool timestamp_c /*= false*/>
+void libmodule::module::SpeedMonitor<len_c, sample_t, timestamp_c>::registers_sent(uint16_t const regaddr, uint8_t const data[], uint16_t const len)
+{
+	//Only a read that starts at Count drains the FIFO, and only the samples that were read in full
+	if(regaddr != stream_offset_c + metadata::speedmonitor::offset::stream::Count || len < metadata::speedmonitor::offset::stream::Buffer)
+		return;
+	//The send buffer is a snapshot, so push_sample may have run since it was taken. Only the samples the master was told about are popped,
+	//less any of them that push_sample has already dropped to make room.
+	uint8_t const sentcount = data[metadata::speedmonitor::offset::stream::Count - metadata::speedmonitor::offset::stream::Count];
+	uint8_t const sentlost = data[metadata::speedmonitor::offset::stream::Lost - metadata::speedmonitor::offset::stream::Count];
+	uint8_t &lost = buffer.pm_ptr[stream_offset_c + metadata::speedmonitor::offset::stream::Lost];
+	uint8_t const dropped = lost - sentlost;
+	lost = 0;
+	uint8_t const received = utility::tmin<uint8_t>(sentcount, (len - metadata::speedmonitor::offset::stream::Buffer) / entry_size);
+	if(received > dropped)
+		stream_pop(received - dropped);
+}
+
+template <size_t len_c, typename sample_t /*= uint32_t*/, bool timestamp_c /*= false*/>
+void libmodule::module::SpeedMonitor<len_c, sample_t, timestamp_c>::stream_pop(uint8_t const count)
+{
+	uint8_t *const countptr = buffer.pm_ptr + stream_offset_c + metadata::speedmonitor::offset::stream::Count;
+	uint8_t *const bufferptr = buffer.pm_ptr + stream_offset_c + metadata::speedmonitor::offset::stream::Buffer;
+	uint8_t const popped = utility::tmin<uint8_t>(count, *countptr);
+	*countptr -= popped;
+	memmove(bufferptr, bufferptr + popped * entry_size, *countptr * entry_size);
+}
+
+template <size_t len_c, typename sample_t /*= uint32_t*/, bool timestamp_c /*= false*/>
+void libmodule::module::SpeedMonitor<len_c, sample_t, timestamp_c>::write_entry(size_t const pos, sample_t const sample, metadata::com::ms_t const time)
+{
+	buffer.serialiseWrite(sample, pos);
+	if(timestamp_c)
+		buffer.serialiseWrite(time, pos + sizeof(sample_t));
+}
+
 template <typename SpeedMonitor_t, size_t count_c>
 void libmodule::module::SpeedMonitorManager<SpeedMonitor_t, count_c>::register_speedMonitor(uint8_t const pos, SpeedMonitor_t *const instance)
 {
-	if(instance == nullptr || pos > count_c) {
+	if(instance == nullptr || pos >= count_c) {
 		hw::panic();
 	}
 
 	instance->buffer.pm_ptr = buffer.pm_ptr + manager_buffer_size_c + pos * instance_buffer_size_c;
 	instance->buffer.pm_len = instance_buffer_size_c;
+	instance->pm_slave = this;
 	pm_monitors[pos] = instance;
 }
 
@@ -288,6 +378,7 @@ void libmodule::module::SpeedMonitorManager<SpeedMonitor_t, count_c>::write_cons
 {
 	//Set sample size, instance count, and sample count
 	buffer.bit_set_mask(metadata::com::offset::Status, sizeof(sample_t) << metadata::speedmonitor::sig::status::SampleSize);
+	buffer.bit_set(metadata::com::offset::Status, metadata::speedmonitor::sig::status::Timestamped, SpeedMonitor_t::timestamped);
 	buffer.serialiseWrite(static_cast<uint8_t>(count_c), metadata::speedmonitor::offset::manager::InstanceCount);
 	buffer.serialiseWrite(static_cast<uint8_t>(len_c), metadata::speedmonitor::offset::manager::SampleCount);
 	//Write constants for attached SpeedMonitors
@@ -296,3 +387,13 @@ void libmodule::module::SpeedMonitorManager<SpeedMonitor_t, count_c>::write_cons
 			pm_monitors[i]->write_constants();
 	}
 }
+
+template <typename SpeedMonitor_t, size_t count_c>
+void libmodule::module::SpeedMonitorManager<SpeedMonitor_t, count_c>::registers_sent(uint16_t const regaddr, uint8_t const data[], uint16_t const len)
+{
+	if(regaddr < manager_buffer_size_c)
+		return;
+	uint8_t const pos = (regaddr - manager_buffer_size_c) / instance_buffer_size_c;
+	if(pos < count_c && pm_monitors[pos] != nullptr)
+		pm_monitors[pos]->registers_sent(regaddr - manager_buffer_size_c - pos * instance_buffer_size_c, data, len);
+}
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <string.h>
+#include <util/delay.h>
 #include "utility.h"
 #include "timer.h"
 
@@ -37,6 +38,41 @@ namespace libmodule {
 			BinaryOutput_t *pm_binaryout;
 			uint8_t pm_index;
 		};
+
+		template <typename>
+		class MultiplexScanner;
+
+		//Sweeps every mux channel once per scan() and latches the results, so reading a channel doesn't touch the select lines (unlike MultiplexDigitalInput)
+		//scan() can be called once per frame from the main loop, or from a timer interrupt
+		//Each channel is given settle_us after being selected for the mux output to settle before it is read (so scan() takes at least channelcount * settle_us)
+		template <typename select_t, uint8_t bitcount_c>
+		class MultiplexScanner<BinaryOutput<select_t, bitcount_c>> {
+		public:
+			using BinaryOutput_t = BinaryOutput<select_t, bitcount_c>;
+			static constexpr uint8_t channelcount = 1 << bitcount_c;
+			//Time from a select line changing to the common input being valid (with margin for the input's RC)
+			static constexpr double settle_us = 1;
+
+			//Input for one channel of the scanner
+			class Channel : public utility::Input<bool> {
+			public:
+				bool get() const override;
+				Channel(MultiplexScanner const *const scanner, uint8_t const index);
+			private:
+				MultiplexScanner const *pm_scanner;
+				uint8_t pm_index;
+			};
+
+			void scan();
+			//State of the channel at the last scan
+			bool get(uint8_t const index) const;
+			MultiplexScanner(utility::Input<bool> const *const commoninput, BinaryOutput_t *const binaryout);
+		private:
+			utility::Input<bool> const *pm_commoninput;
+			BinaryOutput_t *pm_binaryout;
+			//Bitmap of channel states (one byte is written at a time, so can be read while scan() runs in an interrupt)
+			volatile uint8_t pm_states[(channelcount + 7) / 8];
+		};
 	}
 }
 
@@ -76,3 +112,45 @@ template <typename select_t, uint8_t bitcount_c>
 libmodule::userio::MultiplexDigitalInput<libmodule::userio::BinaryOutput<select_t, bitcount_c>>::MultiplexDigitalInput
  (utility::Input<bool> const *const commoninput, BinaryOutput_t *const binaryout, uint8_t const index)
  : pm_commoninput(commoninput), pm_binaryout(binaryout), pm_index(index) {}
+
+template <typename select_t, uint8_t bitcount_c>
+bool libmodule::userio::MultiplexScanner<libmodule::userio::BinaryOutput<select_t, bitcount_c>>::Channel::get() const
+{
+	return pm_scanner->get(pm_index);
+}
+
+template <typename select_t, uint8_t bitcount_c>
+libmodule::userio::MultiplexScanner<libmodule::userio::BinaryOutput<select_t, bitcount_c>>::Channel::Channel(MultiplexScanner const *const scanner, uint8_t const index)
+ : pm_scanner(scanner), pm_index(index)
+{
+	if(pm_index >= channelcount) hw::panic();
+}
+
+template <typename select_t, uint8_t bitcount_c>
+void libmodule::userio::MultiplexScanner<libmodule::userio::BinaryOutput<select_t, bitcount_c>>::scan()
+{
+	if(pm_binaryout == nullptr || pm_commoninput == nullptr) hw::panic();
+	for(uint8_t i = 0; i < channelcount; i++) {
+		pm_binaryout->set_value(i);
+		_delay_us(settle_us);
+		bool const state = pm_commoninput->get();
+		if(state)
+			pm_states[i / 8] |= 1 << i % 8;
+		else
+			pm_states[i / 8] &= ~(1 << i % 8);
+	}
+}
+
+template <typename select_t, uint8_t bitcount_c>
+bool libmodule::userio::MultiplexScanner<libmodule::userio::BinaryOutput<select_t, bitcount_c>>::get(uint8_t const index) const
+{
+	return pm_states[index / 8] & 1 << index % 8;
+}
+
+template <typename select_t, uint8_t bitcount_c>
+libmodule::userio::MultiplexScanner<libmodule::userio::BinaryOutput<select_t, bitcount_c>>::MultiplexScanner(utility::Input<bool> const *const commoninput, BinaryOutput_t *const binaryout)
+ : pm_commoninput(commoninput), pm_binaryout(binaryout)
+{
+	for(auto &states : pm_states)
+		states = 0;
+}
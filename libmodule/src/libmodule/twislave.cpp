@@ -41,11 +41,12 @@ void libmodule::twi::SlaveBufferManager::update()
 				memcpy(pm_sendbuf.buf, pm_header, pm_headerlen);
 			twislave.set_sendBuffer(pm_sendbuf.buf, pm_sendbuf.len);
 		}
-		//+1 for regaddr
-		newbuf = utility::memsizematch<size_t>(pm_recvbuf.buf, pm_recvbuf.len, buffer.pm_len + 1);
+		//+1 for regaddr (+2 in wide mode)
+		size_t const recvlen = buffer.pm_len + (addressing::wide(buffer.pm_len) ? 2 : 1);
+		newbuf = utility::memsizematch<size_t>(pm_recvbuf.buf, pm_recvbuf.len, recvlen);
 		if(newbuf != pm_recvbuf.buf) {
 			pm_recvbuf.buf = newbuf;
-			pm_recvbuf.len = buffer.pm_len + 1;
+			pm_recvbuf.len = recvlen;
 			twislave.set_recvBuffer(pm_recvbuf.buf, pm_recvbuf.len);
 		}
 
@@ -67,6 +68,11 @@ void libmodule::twi::SlaveBufferManager::set_twiaddr(uint8_t const twiaddr)
 	twislave.set_address(twiaddr);
 }
 
+void libmodule::twi::SlaveBufferManager::set_generalcall(bool const enable)
+{
+	twislave.set_generalcall(enable);
+}
+
 bool libmodule::twi::SlaveBufferManager::connected() const
 {
 	return !pm_timer;
@@ -93,20 +99,38 @@ void libmodule::twi::SlaveBufferManager::update_sendbuf()
 	//Stage 3: 5e, 02, 03, 04, 00, 00
 }
 
-void libmodule::twi::SlaveBufferManager::sent(uint8_t const buf[], uint8_t const len) {}
+void libmodule::twi::SlaveBufferManager::sent(uint8_t const buf[], uint16_t const len)
+{
+	if(m_callbacks != nullptr && len > pm_headerlen) {
+		m_callbacks->registers_sent(pm_regaddr, buf + pm_headerlen, len - pm_headerlen);
+		//The callback may have changed the buffer, and the master could read again before update()
+		update_sendbuf();
+	}
+}
 
-void libmodule::twi::SlaveBufferManager::received(uint8_t const buf[], uint8_t const len)
+void libmodule::twi::SlaveBufferManager::received(uint8_t const buf[], uint16_t const len)
 {
 	if(len > 0) {
 		//First byte should be register address
-		auto regaddr = pm_recvbuf.buf[0];
+		uint16_t regaddr = pm_recvbuf.buf[0];
+		uint8_t addrlen = 1;
+		//In wide mode the flag means the low byte of the address follows
+		if(addressing::wide(buffer.pm_len) && (regaddr & addressing::WideFlag)) {
+			if(len < 2)
+				return;
+			regaddr = static_cast<uint16_t>(regaddr & ~addressing::WideFlag) << 8 | pm_recvbuf.buf[1];
+			addrlen = 2;
+		}
 		//If transaction is valid
 		if(regaddr < buffer.pm_len) {
 			//Copy data from the client buffer into the sendbuf with the new regaddr
 			pm_regaddr = regaddr;
 			update_sendbuf();
 			//Copy data into client buffer
-			memcpy(buffer.pm_ptr + regaddr, pm_recvbuf.buf + 1, utility::tmin<uint8_t>(buffer.pm_len - regaddr, len - 1));
+			uint16_t const datalen = utility::tmin<uint16_t>(buffer.pm_len - regaddr, len - addrlen);
+			memcpy(buffer.pm_ptr + regaddr, pm_recvbuf.buf + addrlen, datalen);
+			if(m_callbacks != nullptr && datalen > 0)
+				m_callbacks->registers_received(regaddr, datalen);
 		}
 	}
 }
@@ -12,13 +12,26 @@
 
 namespace libmodule {
 	namespace twi {
+		//Register addresses are one byte, unless the register buffer is longer than NarrowMax (wide mode)
+		//In wide mode an address byte with WideFlag set is the top of a 15 bit address, and the low byte follows it
+		//Addresses below WideFlag are still one byte in wide mode, so the header and common registers are addressed the same way either way
+		namespace addressing {
+			constexpr size_t NarrowMax = 0xff;
+			constexpr size_t WideMax = 0x7fff;
+			constexpr uint8_t WideFlag = 0x80;
+			//Whether a register buffer of len bytes uses wide mode
+			constexpr bool wide(size_t const len) {
+				return len > NarrowMax;
+			}
+		}
+
 		class TWISlave {
 		public:
 			struct Callbacks {
 				//Potentially return from here to tell the TWI slave the next action
 				//Could also have just one callback that takes a TransactionInfo
-				virtual void sent(uint8_t const buf[], uint8_t const len) = 0;
-				virtual void received(uint8_t const buf[], uint8_t const len) = 0;
+				virtual void sent(uint8_t const buf[], uint16_t const len) = 0;
+				virtual void received(uint8_t const buf[], uint16_t const len) = 0;
 			};
 			enum class Result {
 				//Either no transaction or transaction in progress
@@ -38,7 +51,7 @@ namespace libmodule {
 					Receive,
 				} dir;
 				uint8_t const *buf;
-				uint8_t len;
+				uint16_t len;
 
 				TransactionInfo() = default;
 				TransactionInfo(TransactionInfo const &) = default;
@@ -64,28 +77,42 @@ namespace libmodule {
 
 			//Set slave TWI address
 			virtual void set_address(uint8_t const addr) = 0;
+			//Also respond to the general call address (0x00) for writes
+			virtual void set_generalcall(bool const enable) = 0;
 
 			//Set the buffer to accept received data. If len is reached, a NACK will be sent (on the byte after the last)
-			virtual void set_recvBuffer(uint8_t *const buf, uint8_t const len) = 0;
+			virtual void set_recvBuffer(uint8_t *const buf, uint16_t const len) = 0;
 			//Set the buffer to send data. If len is reached, zeros will be transmitted afterwards
-			virtual void set_sendBuffer(uint8_t const *const buf, uint8_t const len) = 0;
+			virtual void set_sendBuffer(uint8_t const *const buf, uint16_t const len) = 0;
 		};
 		
 		//Manages a register based read/write buffer to be accessed by a master
 		//There is no register metadata, which means that the master could easily overwrite read-only data in the buffer
+		//Buffers longer than addressing::NarrowMax (up to addressing::WideMax) use wide register addresses
 		class SlaveBufferManager : public TWISlave::Callbacks  {
 		public:
+			//Lets a module react to the master reading registers (e.g. to drain a FIFO). Called from the TWI interrupt.
+			class Callbacks {
+				friend SlaveBufferManager;
+				//regaddr is where the read started, data is the register bytes as the master received them, and len is the number of them (not including the header)
+				virtual void registers_sent(uint16_t const regaddr, uint8_t const data[], uint16_t const len) = 0;
+				//regaddr is where the write started, len is the number of register bytes written (already copied into the buffer)
+				virtual void registers_received(uint16_t const regaddr, uint16_t const len) = 0;
+			};
+			Callbacks *m_callbacks = nullptr;
+
 			void update();
 
 			void set_twiaddr(uint8_t const twiaddr);
+			void set_generalcall(bool const enable);
 			void set_timeout(size_t const timeout);
 			//Returns true if timeout between transactions has not been reached
 			bool connected() const;
 
 			SlaveBufferManager(TWISlave &twislave, utility::Buffer &buffer, uint8_t const header[] = nullptr, uint8_t const headerlen = 0);
 		private:
-			void sent(uint8_t const buf[], uint8_t const len) override;
-			void received(uint8_t const buf[], uint8_t const len) override;
+			void sent(uint8_t const buf[], uint16_t const len) override;
+			void received(uint8_t const buf[], uint16_t const len) override;
 			
 			void update_sendbuf();
 
@@ -95,13 +122,13 @@ namespace libmodule {
 			uint8_t pm_headerlen = 0;
 			struct {
 				uint8_t *buf = nullptr;
-				uint8_t len = 0;
+				uint16_t len = 0;
 			} pm_sendbuf;
 			struct {
 				uint8_t *buf = nullptr;
-				uint8_t len = 0;
+				uint16_t len = 0;
 			} pm_recvbuf;
-			uint8_t pm_regaddr = 0;
+			uint16_t pm_regaddr = 0;
 			Timer1k pm_timer;
 			size_t pm_timeout = 1000;
 		};
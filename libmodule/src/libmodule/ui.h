@@ -135,6 +135,46 @@ namespace libmodule {
 				bool run_init = true;
 			};
 
+			/* List of items like List, but the items are a constant table in PROGMEM, so a menu needs no RAM for its items and nothing is allocated when it opens.
+			 * T is the class inheriting from Menu, and the item callbacks are member functions of T.
+			 * pgm_items: the table of items (in PROGMEM).
+			 * wrap: if true, the menu will wrap around.
+			 * Navigation
+			 *	up: move up item
+			 *	down: move down item
+			 *	left: menu_on_back (ui_finish by default)
+			 *	right/centre: select (click) item
+			 */
+			template <typename T>
+			class Menu : public Screen<Common> {
+			public:
+				struct Item {
+					char name[4];
+					//Called when the item is clicked. If nullptr is not returned, the menu will spawn the returned screen.
+					Screen *(T::*on_click)();
+					//Called when the screen returned in on_click finishes, if any was returned.
+					void (T::*on_finish)(Screen *const);
+					//Called every cycle while the item is the current item, with the name about to be shown (so it can be changed).
+					//firstcycle will be true if the item has just come into view.
+					void (T::*on_highlight)(char name[4], bool const firstcycle);
+				};
+				template <uint8_t count_c>
+				Menu(Item const (&pgm_items)[count_c], bool const wrap = true);
+			protected:
+				void ui_update() override;
+				void ui_on_childComplete() override;
+				//Called when left is pressed. Unless an inherited class overrides this function, it calls ui_finish.
+				virtual void menu_on_back();
+			private:
+				Item read_item(uint8_t const pos) const;
+
+				Item const *pm_items;
+				uint8_t pm_count;
+				uint8_t pm_currentitem = 0;
+				bool pm_wrap : 1;
+				bool pm_runinit : 1;
+			};
+
 			/* List of items. When clicked, items toggle on or off. This is shown on the left decimal point.
 			 * wrap: if true, the list will wrap around.
 			 * Navigation:
@@ -296,6 +336,86 @@ libmodule::ui::segdpad::List::Item_MemFnCallback<T>::Item_MemFnCallback(T *const
 : callback_ptr(callback_ptr), callback_click(callback_click), callback_finish(callback_finish), callback_highlight(callback_highlight) {}
 
 
+template <typename T>
+template <uint8_t count_c>
+libmodule::ui::segdpad::Menu<T>::Menu(Item const (&pgm_items)[count_c], bool const wrap /*= true*/) : pm_items(pgm_items), pm_count(count_c), pm_wrap(wrap), pm_runinit(true) {}
+
+template <typename T>
+void libmodule::ui::segdpad::Menu<T>::ui_update()
+{
+	//If there are no items, write "--"
+	if(pm_count == 0) {
+		ui_common->segs.write_characters("--", 2, 0);
+		//Check for finish
+		if(ui_common->dpad.left.get()) menu_on_back();
+		return;
+	}
+
+	//Used to determine whether to set firstcycle in on_highlight
+	uint8_t const previous_item = pm_currentitem;
+
+	//Move up an item
+	if(ui_common->dpad.up.get()) {
+		if(pm_currentitem > 0) pm_currentitem--;
+		else if(pm_wrap) pm_currentitem = pm_count - 1;
+		else ui_common->dp_right_blinker.run_pattern(pattern::rubberband);
+	}
+	//Move down an item
+	else if(ui_common->dpad.down.get()) {
+		if(++pm_currentitem >= pm_count) {
+			if(pm_wrap) pm_currentitem = 0;
+			else {
+				pm_currentitem--;
+				ui_common->dp_right_blinker.run_pattern(pattern::rubberband);
+			}
+		}
+	}
+	//Go back a screen
+	else if(ui_common->dpad.left.get()) {
+		menu_on_back();
+	}
+	//Select the item
+	else if(ui_common->dpad.right.get() || ui_common->dpad.centre.get()) {
+		Item const item = read_item(pm_currentitem);
+		if(item.on_click != nullptr) {
+			auto res = (static_cast<T *>(this)->*item.on_click)();
+			if(res != nullptr) ui_spawn(res);
+		}
+	}
+	//The click may have finished or spawned, in which case the display is left to whatever is next
+	if(ui_finished || ui_child != nullptr) return;
+
+	//Update the display (the name is copied out of the table so that on_highlight can change it)
+	Item const item = read_item(pm_currentitem);
+	char name[sizeof item.name];
+	memcpy(name, item.name, sizeof name);
+	if(item.on_highlight != nullptr) (static_cast<T *>(this)->*item.on_highlight)(name, (pm_currentitem != previous_item) | pm_runinit);
+	pm_runinit = false;
+	ui_common->segs.write_characters(name, sizeof name, userio::IC_LTD_2601G_11::OVERWRITE_LEFT |
+		((ui_common->dp_right_blinker.currentMode() == userio::Blinker::Mode::Solid) ? userio::IC_LTD_2601G_11::OVERWRITE_RIGHT : 0));
+}
+
+template <typename T>
+void libmodule::ui::segdpad::Menu<T>::ui_on_childComplete()
+{
+	Item const item = read_item(pm_currentitem);
+	if(item.on_finish != nullptr) (static_cast<T *>(this)->*item.on_finish)(ui_child);
+}
+
+template <typename T>
+void libmodule::ui::segdpad::Menu<T>::menu_on_back()
+{
+	ui_finish();
+}
+
+template <typename T>
+auto libmodule::ui::segdpad::Menu<T>::read_item(uint8_t const pos) const -> Item
+{
+	Item item;
+	memcpy_P(&item, &pm_items[pos], sizeof item);
+	return item;
+}
+
 template <typename T>
 constexpr T libmodule::ui::segdpad::NumberInputDecimal::powi(T const base, T const exp)
 {
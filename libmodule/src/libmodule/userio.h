@@ -135,6 +135,49 @@ namespace userio {
 		bool pm_fire : 1;
 	};
 
+	//Debounces up to 8 * sizeof(bitmap_t) inputs at once, using a vertical counter (a 2 bit counter for each input, stored as two bitmaps)
+	//An input only changes state once it has read the new state for 4 update() calls in a row, which takes a few bitwise operations for every input together
+	//Give a Channel to InStates, ButtonTimer or RapidInput so that they see the debounced state (and so debounced press/release edges)
+	template <typename bitmap_t = uint8_t>
+	class Debouncer {
+	public:
+		static constexpr uint8_t inputcount = sizeof(bitmap_t) * 8;
+		using Input_t = utility::Input<bool>;
+
+		//Debounced state of one input
+		class Channel : public Input_t {
+		public:
+			bool get() const override;
+			Channel(Debouncer const *const debouncer, uint8_t const index);
+		private:
+			Debouncer const *pm_debouncer;
+			uint8_t pm_index;
+		};
+
+		//Reads every input that has been set (bit index is the input index), and debounces them
+		void update();
+		//Debounces a sample of every input (for inputs that are already a bitmap, e.g. a port)
+		void update(bitmap_t const sample);
+		void set_input(uint8_t const index, Input_t const *const input);
+
+		bool get(uint8_t const index) const;
+		//Debounced states
+		bitmap_t state() const;
+		//Inputs that changed from false to true in the last update
+		bitmap_t pressed() const;
+		//Inputs that changed from true to false in the last update
+		bitmap_t released() const;
+
+		Debouncer();
+	private:
+		Input_t const *pm_input[inputcount];
+		bitmap_t pm_state = 0;
+		bitmap_t pm_changed = 0;
+		//Counters count down from 3 while an input differs from its state, and are reset to 3 when it doesn't
+		bitmap_t pm_count0 = ~static_cast<bitmap_t>(0);
+		bitmap_t pm_count1 = ~static_cast<bitmap_t>(0);
+	};
+
 	//Type alias (consider moving to global namespace)
 	using BlinkerTimer1k = BlinkerTimer<Timer1k>;
 	using ButtonTimer1k = ButtonTimer<Stopwatch1k>;
@@ -376,3 +419,79 @@ libmodule::userio::RapidInput<levels_c, Stopwatch_t, tick_t>::RapidInput(Input_t
 	pm_levelindex = 0;
 	pm_fire = false;
 }
+
+//---Debouncer---
+
+template <typename bitmap_t /*= uint8_t*/>
+bool libmodule::userio::Debouncer<bitmap_t>::Channel::get() const
+{
+	return pm_debouncer->get(pm_index);
+}
+
+template <typename bitmap_t /*= uint8_t*/>
+libmodule::userio::Debouncer<bitmap_t>::Channel::Channel(Debouncer const *const debouncer, uint8_t const index) : pm_debouncer(debouncer), pm_index(index)
+{
+	if(pm_index >= inputcount) hw::panic();
+}
+
+template <typename bitmap_t /*= uint8_t*/>
+void libmodule::userio::Debouncer<bitmap_t>::update()
+{
+	bitmap_t sample = 0;
+	for(uint8_t i = 0; i < inputcount; i++) {
+		if(pm_input[i] != nullptr && pm_input[i]->get())
+			sample |= static_cast<bitmap_t>(1) << i;
+	}
+	update(sample);
+}
+
+template <typename bitmap_t /*= uint8_t*/>
+void libmodule::userio::Debouncer<bitmap_t>::update(bitmap_t const sample)
+{
+	//Inputs that differ from their debounced state
+	bitmap_t const delta = sample ^ pm_state;
+	//Count down the inputs in delta, and reset the rest to 3
+	pm_count0 = ~(pm_count0 & delta);
+	pm_count1 = pm_count0 ^ (pm_count1 & delta);
+	//Inputs whose counter rolled over (were different for 4 updates) change state
+	pm_changed = delta & pm_count0 & pm_count1;
+	pm_state ^= pm_changed;
+}
+
+template <typename bitmap_t /*= uint8_t*/>
+void libmodule::userio::Debouncer<bitmap_t>::set_input(uint8_t const index, Input_t const *const input)
+{
+	if(index >= inputcount) hw::panic();
+	pm_input[index] = input;
+}
+
+template <typename bitmap_t /*= uint8_t*/>
+bool libmodule::userio::Debouncer<bitmap_t>::get(uint8_t const index) const
+{
+	return pm_state & static_cast<bitmap_t>(1) << index;
+}
+
+template <typename bitmap_t /*= uint8_t*/>
+bitmap_t libmodule::userio::Debouncer<bitmap_t>::state() const
+{
+	return pm_state;
+}
+
+template <typename bitmap_t /*= uint8_t*/>
+bitmap_t libmodule::userio::Debouncer<bitmap_t>::pressed() const
+{
+	return pm_changed & pm_state;
+}
+
+template <typename bitmap_t /*= uint8_t*/>
+bitmap_t libmodule::userio::Debouncer<bitmap_t>::released() const
+{
+	return pm_changed & ~pm_state;
+}
+
+template <typename bitmap_t /*= uint8_t*/>
+libmodule::userio::Debouncer<bitmap_t>::Debouncer()
+{
+	for(auto &input : pm_input)
+		input = nullptr;
+}
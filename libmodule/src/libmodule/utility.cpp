@@ -11,6 +11,7 @@
 
 #include "utility.h"
 
+#ifdef __AVR__
 /** This function is automatically called whenever `new` is called.
  * 
  * Calls `malloc()` in an `ATOMIC_BLOCK`.
@@ -65,6 +66,7 @@ void __cxa_pure_virtual()
 {
 	libmodule::hw::panic();
 }
+#endif
 
 //toggle() is documented in utility.h
 void libmodule::utility::Output<bool>::toggle() {}
@@ -25,6 +25,8 @@
  * @{
  */
 
+//Host builds (e.g. utilities/twibussim) use the standard library versions
+#ifdef __AVR__
 ///[atomic] C++ `new` implementation.
 void *operator new(unsigned int len);
 ///C++ placement `new` implementation.
@@ -35,6 +37,9 @@ extern "C" {
 ///GCC pure `virtual` function implementation.
 void __cxa_pure_virtual();
 }
+#else
+#include <new>
+#endif
 
 /**@}*/
 
@@ -0,0 +1,59 @@
+// formattest.cpp : Defines the entry point for the console application.
+//
+
+//Checks libmodule::userio::format_fixed against snprintf on the host
+//format_fixed is used instead of snprintf with "%2.<sig10>f" (which needs the floating point printf), so has to give the same string
+//Usage: formattest
+//         Prints PASS or FAIL. Exits with 1 if it failed.
+//Build (from this directory, as a single command, the <avr/io.h> and <util/atomic.h> stand ins are shared with twibussim):
+//  g++ -std=gnu++14 -O2 -funsigned-char -Ihost -I../../twibussim/twibussim/host -I../../../libmodule/src formattest.cpp
+//      ../../../libmodule/src/libmodule/{utility,userio,ltd_2601g_11,74hc595}.cpp -o formattest
+
+#include <iostream>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <libmodule/ltd_2601g_11.h>
+
+void libmodule::hw::panic()
+{
+	std::cerr << "panic() called\n";
+	std::exit(1);
+}
+
+namespace {
+	//Every int16_t value is checked with every sig10 and len that fits the longest result
+	bool format_fixed_matches_snprintf()
+	{
+		constexpr double scale[] = {1, 10, 100, 1000, 10000};
+		for(int32_t value = INT16_MIN; value <= INT16_MAX; value++) {
+			for(uint8_t sig10 = 0; sig10 < sizeof scale / sizeof *scale; sig10++) {
+				for(uint8_t len = 1; len <= 9; len++) {
+					char expected[10];
+					std::snprintf(expected, len, "%2.*f", sig10, value / scale[sig10]);
+					//Filled so that a missing '\0' shows up
+					char result[10];
+					std::memset(result, 'x', sizeof result);
+					libmodule::userio::format_fixed(result, len, value, sig10);
+					if(std::strcmp(expected, result) != 0) {
+						std::cout << "value " << value << ", sig10 " << +sig10 << ", len " << +len << ": expected \"" << expected << "\"\n";
+						return false;
+					}
+				}
+			}
+		}
+		//Past what format_fixed supports, the string is left empty
+		char result[] = "x";
+		libmodule::userio::format_fixed(result, sizeof result, 1, 5);
+		return result[0] == '\0';
+	}
+}
+
+int main()
+{
+	bool const pass = format_fixed_matches_snprintf();
+	std::cout << (pass ? "PASS " : "FAIL ") << "format_fixed matches snprintf\n";
+	return pass ? 0 : 1;
+}
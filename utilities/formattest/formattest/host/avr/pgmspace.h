@@ -0,0 +1,15 @@
+//Created: 20/10/2019 2:14:08 PM
+
+/** \file
+ \brief Host stand in for <avr/pgmspace.h>.
+ \details There is only one address space on the host, so program memory is read like any other memory. Only what libmodule uses is defined.
+ \date Created 2019-10-20
+ \author Teddy.Hut
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*reinterpret_cast<uint8_t const *>(addr))
@@ -0,0 +1,13 @@
+//Created: 20/10/2019 2:15:31 PM
+
+/** \file
+ \brief Host stand in for <util/delay.h>.
+ \details Simulated hardware doesn't need time to settle, so the delays do nothing.
+ \date Created 2019-10-20
+ \author Teddy.Hut
+ */
+
+#pragma once
+
+inline void _delay_us(double const) {}
+inline void _delay_ms(double const) {}
@@ -0,0 +1,14 @@
+//Created: 19/10/2019 1:05:12 PM
+
+/** \file
+ \brief Host stand in for <avr/io.h>.
+ \details Only the types are needed by the parts of libmodule and TestMaster built into the simulator (no registers are accessed).
+ \date Created 2019-10-19
+ \author Teddy.Hut
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <stddef.h>
@@ -0,0 +1,23 @@
+//Created: 19/10/2019 1:06:30 PM
+
+/** \file
+ \brief Source file for the host timerhardware.h.
+ \date Created 2019-10-19
+ \author Teddy.Hut
+ */
+
+#include "timerhardware.h"
+
+void libmodule::time::isr_rtc()
+{
+	TimerBase<1000>::handle_isr();
+}
+
+void libmodule::time::TimerBase<1000>::handle_isr()
+{
+	for(il_count_t i = 0; i < il_instances.size(); i++) {
+		static_cast<TimerBase *>(il_instances[i])->tick();
+	}
+}
+
+void libmodule::time::TimerBase<1000>::start_daemon() {}
@@ -0,0 +1,34 @@
+//Created: 19/10/2019 1:06:02 PM
+
+/** \file
+ \brief Host implementation of the 1kHz libmodule timer.
+ \details Instead of the RTC interrupt, sim::Bus calls isr_rtc() every simulated millisecond.
+ \date Created 2019-10-19
+ \author Teddy.Hut
+ */
+
+#pragma once
+
+#include <libmodule/utility.h>
+#include <libmodule/timercommon.h>
+
+namespace libmodule {
+namespace time {
+
+void isr_rtc();
+
+//Specialization for 1000Hz timers. Ticked by the simulated bus.
+template <>
+class TimerBase<1000> : public utility::InstanceList<TimerBase<1000>> {
+	template <size_t ...>
+	friend void start_timer_daemons();
+	friend void isr_rtc();
+protected:
+	virtual void tick() = 0;
+private:
+	static void start_daemon();
+	static void handle_isr();
+};
+
+} //time
+} //libmodule
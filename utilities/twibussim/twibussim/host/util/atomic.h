@@ -0,0 +1,14 @@
+//Created: 19/10/2019 1:05:40 PM
+
+/** \file
+ \brief Host stand in for <util/atomic.h>.
+ \details The simulator is single threaded (slave "interrupts" are run inline), so an atomic block is just a block.
+ \date Created 2019-10-19
+ \author Teddy.Hut
+ */
+
+#pragma once
+
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_FORCEON 0
+#define ATOMIC_BLOCK(type) for(bool atomic_block_once = true; atomic_block_once; atomic_block_once = false)
@@ -0,0 +1,231 @@
+//Created: 19/10/2019 3:20:41 PM
+
+/** \file
+ \brief Source file for report.h.
+ \date Created 2019-10-19
+ \author Teddy.Hut
+ */
+
+#include "report.h"
+
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <libmodule/module.h>
+#include <runtime/module.h>
+
+#include "simbus.h"
+
+namespace {
+	namespace config {
+		//Time taken by one pass of the main loops (ns)
+		constexpr uint64_t loop_ns = 50000;
+		constexpr uint8_t addr = 0x02;
+		//Time the module interrupt takes to respond to each byte (ns)
+		constexpr uint32_t slave_stretch_ns = 5000;
+		//Cycles to wait before measuring (names and constants are read in the first cycles)
+		constexpr uint16_t warmup_cycles = 10;
+		constexpr uint16_t measure_cycles = 30;
+		//Gives up if a module doesn't reach the cycle count within this time (ns)
+		constexpr uint64_t timeout_ns = 60000000000ull;
+		//Allowed difference from the baseline before it counts as a regression
+		constexpr double tolerance_ratio = 0.001;
+		constexpr double tolerance_bus = 1.01;
+	}
+
+	constexpr uint32_t frequencies[] = {100000, 400000};
+
+	using speedmonitor_t = libmodule::module::SpeedMonitor<8, uint16_t>;
+
+	char const *name(report::ModuleType const type)
+	{
+		switch(type) {
+		case report::ModuleType::Horn:
+			return "Horn";
+		case report::ModuleType::SpeedMonitor:
+			return "SpeedMonitor";
+		case report::ModuleType::SpeedMonitorStream:
+			return "SpeedMonitorStream";
+		case report::ModuleType::MotorController:
+			return "MotorController";
+		default:
+			return "?";
+		}
+	}
+
+	//Reads "<name> <frequency> <ratio> <bus_us>" lines, # starts a comment
+	bool read_baseline(char const *const path, std::vector<report::Efficiency> &entries)
+	{
+		std::ifstream file(path);
+		if(!file)
+			return false;
+		std::string line;
+		while(std::getline(file, line)) {
+			if(line.empty() || line[0] == '#')
+				continue;
+			std::istringstream stream(line);
+			std::string modulename;
+			report::Efficiency entry{};
+			double ratio;
+			if(!(stream >> modulename >> entry.frequency >> ratio >> entry.bus_us))
+				return false;
+			for(uint8_t i = 0; i < static_cast<uint8_t>(report::ModuleType::_size); i++) {
+				if(modulename == name(static_cast<report::ModuleType>(i)))
+					entry.type = static_cast<report::ModuleType>(i);
+			}
+			//Stored as payload/wirebytes so ratio() gives it back
+			entry.payload = ratio;
+			entry.wirebytes = 1;
+			entries.push_back(entry);
+		}
+		return true;
+	}
+}
+
+double report::Efficiency::ratio() const
+{
+	return wirebytes > 0 ? payload / wirebytes : 0;
+}
+
+report::Efficiency report::measure(ModuleType const type, uint32_t const frequency)
+{
+	sim::BusConfig busconfig;
+	busconfig.frequency = frequency;
+	sim::Bus bus(busconfig);
+	sim::Master twimaster(bus);
+	sim::Slave twislave;
+	twislave.m_stretch_ns = config::slave_stretch_ns;
+	bus.attach(twislave);
+
+	//shared_ptr is used since libmodule::module::Slave has no virtual destructor (make_shared keeps the right deleter)
+	std::shared_ptr<libmodule::module::Slave> slave;
+	std::unique_ptr<rt::module::Master> master;
+	std::function<void()> update_slave;
+	std::function<void()> update_master;
+	speedmonitor_t speedmonitor[2];
+
+	switch(type) {
+	case ModuleType::Horn: {
+		auto horn = std::make_shared<libmodule::module::Horn>(twislave);
+		update_slave = [horn]() { horn->update(); };
+		slave = horn;
+		master.reset(new rt::module::Horn(twimaster, config::addr));
+		break;
+		}
+	case ModuleType::SpeedMonitor:
+	case ModuleType::SpeedMonitorStream: {
+		auto manager = std::make_shared<libmodule::module::SpeedMonitorManager<speedmonitor_t, 2>>(twislave);
+		for(uint8_t i = 0; i < 2; i++)
+			manager->register_speedMonitor(i, &speedmonitor[i]);
+		update_slave = [manager]() { manager->update(); };
+		slave = manager;
+		auto monitor = new rt::module::SpeedMonitorManager<uint16_t>(twimaster, config::addr, 1000 / 30, type == ModuleType::SpeedMonitorStream);
+		update_master = [monitor]() { monitor->update(); };
+		master.reset(monitor);
+		break;
+		}
+	case ModuleType::MotorController: {
+		auto motorcontroller = std::make_shared<libmodule::module::MotorController>(twislave);
+		update_slave = [motorcontroller]() { motorcontroller->Slave::update(); motorcontroller->update(); };
+		slave = motorcontroller;
+		master.reset(new rt::module::MotorController(twimaster, config::addr));
+		break;
+		}
+	default:
+		libmodule::hw::panic();
+	}
+	slave->set_twiaddr(config::addr);
+	slave->set_name(name(type));
+	slave->set_operational(true);
+
+	auto const &manager = master->buffermanager;
+	Efficiency result{type, frequency, 0, 0, 0, 0};
+	uint16_t lastcycle = manager.m_cycles;
+	sim::BusStatistics start{};
+	while(manager.m_cycles < config::warmup_cycles + config::measure_cycles && bus.now() < config::timeout_ns) {
+		update_slave();
+		master->update();
+		if(update_master)
+			update_master();
+		bus.run(config::loop_ns);
+
+		if(manager.m_cycles == lastcycle)
+			continue;
+		lastcycle = manager.m_cycles;
+		if(manager.m_cycles == config::warmup_cycles) {
+			start = bus.m_statistics;
+			continue;
+		}
+		if(manager.m_cycles > config::warmup_cycles) {
+			result.transactions += manager.m_lastCycleMetrics.transactions;
+			result.payload += manager.m_lastCycleMetrics.payload;
+		}
+	}
+	if(manager.m_cycles < config::warmup_cycles + config::measure_cycles)
+		libmodule::hw::panic();
+	auto const &end = bus.m_statistics;
+	result.transactions /= config::measure_cycles;
+	result.payload /= config::measure_cycles;
+	result.wirebytes = static_cast<double>(end.address_bytes - start.address_bytes + end.data_bytes - start.data_bytes) / config::measure_cycles;
+	result.bus_us = static_cast<double>(end.busy_ns - start.busy_ns) / 1000 / config::measure_cycles;
+	return result;
+}
+
+int report::run(std::ostream &out, char const *const baseline, bool const write_baseline)
+{
+	std::vector<Efficiency> results;
+	for(auto frequency : frequencies) {
+		for(uint8_t i = 0; i < static_cast<uint8_t>(ModuleType::_size); i++)
+			results.push_back(measure(static_cast<ModuleType>(i), frequency));
+	}
+
+	out << std::fixed << std::setprecision(1);
+	out << std::left << std::setw(20) << "Module" << std::right << std::setw(8) << "Hz" << std::setw(8) << "Trans" << std::setw(8) << "Wire"
+	    << std::setw(9) << "Payload" << std::setw(8) << "Eff%" << std::setw(10) << "Bus us" << std::setw(10) << "Max Hz" << '\n';
+	for(auto const &entry : results) {
+		out << std::left << std::setw(20) << name(entry.type) << std::right << std::setw(8) << entry.frequency << std::setw(8) << entry.transactions
+		    << std::setw(8) << entry.wirebytes << std::setw(9) << entry.payload << std::setw(8) << entry.ratio() * 100
+		    << std::setw(10) << entry.bus_us << std::setw(10) << 1000000 / entry.bus_us << '\n';
+	}
+
+	if(baseline == nullptr)
+		return 0;
+	if(write_baseline) {
+		std::ofstream file(baseline);
+		file << "# Written by twibussim report, see report.h\n# module frequency efficiency bus_us_per_cycle\n";
+		file << std::fixed << std::setprecision(4);
+		for(auto const &entry : results)
+			file << name(entry.type) << ' ' << entry.frequency << ' ' << entry.ratio() << ' ' << entry.bus_us << '\n';
+		return file ? 0 : 2;
+	}
+
+	std::vector<Efficiency> entries;
+	if(!read_baseline(baseline, entries)) {
+		out << "Could not read baseline " << baseline << '\n';
+		return 2;
+	}
+	int rtrn = 0;
+	for(auto const &entry : results) {
+		for(auto const &base : entries) {
+			if(base.type != entry.type || base.frequency != entry.frequency)
+				continue;
+			if(entry.ratio() < base.ratio() - config::tolerance_ratio) {
+				out << "REGRESSION: " << name(entry.type) << " at " << entry.frequency << "Hz efficiency " << entry.ratio() * 100 << "% (baseline " << base.ratio() * 100 << "%)\n";
+				rtrn = 1;
+			}
+			if(entry.bus_us > base.bus_us * config::tolerance_bus) {
+				out << "REGRESSION: " << name(entry.type) << " at " << entry.frequency << "Hz bus time " << entry.bus_us << "us per cycle (baseline " << base.bus_us << "us)\n";
+				rtrn = 1;
+			}
+		}
+	}
+	if(rtrn == 0)
+		out << "No regressions against " << baseline << '\n';
+	return rtrn;
+}
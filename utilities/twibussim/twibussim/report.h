@@ -0,0 +1,51 @@
+//Created: 19/10/2019 3:20:14 PM
+
+/** \file
+ \brief Module register protocol efficiency report.
+ \details Each module type is run on its own on a simulated bus, and once it reaches steady state (after the names and constants have been read) the bytes on the wire are compared to the register bytes the master actually needed.
+ \n The results can be checked against a baseline file, so that protocol changes that cost bus bandwidth are caught.
+ \date Created 2019-10-19
+ \author Teddy.Hut
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <iosfwd>
+
+///Primary namespace for report.h.
+namespace report {
+	enum class ModuleType : uint8_t {
+		Horn,
+		SpeedMonitor,
+		//SpeedMonitor with the master in stream mode
+		SpeedMonitorStream,
+		MotorController,
+		_size,
+	};
+
+	///Steady state bus usage per master update cycle.
+	struct Efficiency {
+		ModuleType type;
+		uint32_t frequency;
+		double transactions;
+		///Address and data bytes (including the 0x5E header and register address bytes).
+		double wirebytes;
+		///Register bytes the master needed.
+		double payload;
+		///Bus time, including START/STOP conditions and clock stretching (us).
+		double bus_us;
+		///payload / wirebytes
+		double ratio() const;
+	};
+
+	///Runs \a type alone on a bus at \a frequency and measures the steady state.
+	Efficiency measure(ModuleType const type, uint32_t const frequency);
+
+	/** \brief Measures every module type at 100kHz and 400kHz and prints a table to \a out.
+	 \param baseline If not \c nullptr, the results are compared to the file, and any that are worse than it are reported.
+	 \param write_baseline If \c true, \a baseline is overwritten with the new results instead.
+	 \return 0 if there was no regression, 1 if there was, 2 if the baseline could not be read.
+	 */
+	int run(std::ostream &out, char const *const baseline, bool const write_baseline);
+}
@@ -0,0 +1,218 @@
+//Created: 20/10/2019 10:05:40 AM
+
+/** \file
+ \brief Source file for scenario.h.
+ \date Created 2019-10-20
+ \author Teddy.Hut
+ */
+
+#include "scenario.h"
+
+#include <ostream>
+
+#include <libmodule/twislave.h>
+#include <libmodule/module.h>
+#include <runtime/rttwi.h>
+#include <runtime/module.h>
+
+#include "simbus.h"
+
+namespace {
+	namespace config {
+		//Time taken by one pass of the main loops (ns)
+		constexpr uint64_t loop_ns = 50000;
+		constexpr uint8_t addr = 0x02;
+		//Gives up if a scenario doesn't finish within this time (ns)
+		constexpr uint64_t timeout_ns = 10000000000ull;
+	}
+
+	/* A write register between two regularly read registers, close enough that the reads are merged into one transaction over it.
+	 * The write must still be sent, and not be skipped as part of the read.
+	 */
+	bool write_inside_merged_read()
+	{
+		sim::Bus bus;
+		sim::Master twimaster(bus);
+		sim::Slave twislave;
+		bus.attach(twislave);
+
+		uint8_t slavemem[8] = {};
+		libmodule::utility::Buffer slavebuffer(slavemem, sizeof slavemem);
+		libmodule::twi::SlaveBufferManager slavemanager(twislave, slavebuffer);
+		slavemanager.set_twiaddr(config::addr);
+
+		uint8_t mastermem[8] = {};
+		libmodule::utility::Buffer masterbuffer(mastermem, sizeof mastermem);
+		rt::twi::RegisterDesc regs[] = {
+			{false, true, true, 2, 0},
+			{true, false, false, 1, 3},
+			{false, true, true, 2, 5},
+		};
+		rt::twi::ModuleRegMeta regmeta;
+		regmeta.regs = regs;
+		regmeta.count = sizeof regs / sizeof *regs;
+		rt::twi::MasterBufferManager manager(twimaster, config::addr, masterbuffer, regmeta, 1000 / 30, 0, true);
+
+		uint8_t const value = 0x42;
+		bool written = false;
+		while(bus.now() < config::timeout_ns) {
+			slavemanager.update();
+			manager.update();
+			bus.run(config::loop_ns);
+			//Let the reads settle into their merged transaction first
+			if(!written && manager.m_cycles >= 2) {
+				masterbuffer.write(&value, sizeof value, 3);
+				written = true;
+			}
+			if(written && manager.m_cycles >= 5)
+				break;
+		}
+		return slavemem[3] == value;
+	}
+
+	/* A write register between two High priority read registers that are merged into one transaction over it, where the write is Normal priority
+	 * and still queued (queueUpdate) from a cycle that was cut short. The read must not copy over the queued write or mark it as done.
+	 */
+	bool queued_write_inside_other_pass_read()
+	{
+		sim::Bus bus;
+		sim::Master twimaster(bus);
+		sim::Slave twislave;
+		bus.attach(twislave);
+
+		uint8_t slavemem[8] = {};
+		libmodule::utility::Buffer slavebuffer(slavemem, sizeof slavemem);
+		libmodule::twi::SlaveBufferManager slavemanager(twislave, slavebuffer);
+		slavemanager.set_twiaddr(config::addr);
+
+		uint8_t mastermem[8] = {};
+		libmodule::utility::Buffer masterbuffer(mastermem, sizeof mastermem);
+		rt::twi::RegisterDesc regs[] = {
+			{false, true, true, 2, 0, false, rt::twi::RegisterDesc::High},
+			{true, false, false, 1, 3, false, rt::twi::RegisterDesc::Normal},
+			{false, true, true, 2, 5, false, rt::twi::RegisterDesc::High},
+		};
+		rt::twi::ModuleRegMeta regmeta;
+		regmeta.regs = regs;
+		regmeta.count = sizeof regs / sizeof *regs;
+		rt::twi::MasterBufferManager manager(twimaster, config::addr, masterbuffer, regmeta, 1000 / 30, 0, true);
+
+		uint8_t const value = 0x42;
+		bool written = false;
+		uint16_t writtencycle = 0;
+		while(bus.now() < config::timeout_ns) {
+			slavemanager.update();
+			manager.update();
+			bus.run(config::loop_ns);
+			//Between cycles, leave the write as if it had been queued by a cycle that ended before it was sent
+			if(!written && manager.m_cycles >= 2) {
+				mastermem[3] = value;
+				regs[1].queueUpdate = true;
+				written = true;
+				writtencycle = manager.m_cycles;
+			}
+			if(written && manager.m_cycles >= writtencycle + 3)
+				break;
+		}
+		return slavemem[3] == value && mastermem[3] == value;
+	}
+
+	using speedmonitor_t = libmodule::module::SpeedMonitor<8, uint16_t>;
+
+	//Gives access to the slave's buffer manager, so that the TWI callbacks can be intercepted
+	class HookedSpeedMonitorManager : public libmodule::module::SpeedMonitorManager<speedmonitor_t, 1> {
+	public:
+		libmodule::twi::TWISlave::Callbacks &twi_callbacks() { return buffermanager; }
+		using SpeedMonitorManager::SpeedMonitorManager;
+	};
+
+	//Pushes a sample after a read has been sent, but before the slave has been told about it (as if push_sample had interrupted the TWI interrupt)
+	class PushBeforeSent : public libmodule::twi::TWISlave::Callbacks {
+	public:
+		void sent(uint8_t const buf[], uint16_t const len) override {
+			if(m_armed && m_pushed < m_total)
+				monitor.push_sample(m_pushed++);
+			next.sent(buf, len);
+		}
+		void received(uint8_t const buf[], uint16_t const len) override {
+			next.received(buf, len);
+		}
+		bool m_armed = false;
+		uint16_t m_pushed = 0;
+		uint16_t m_total = 0;
+
+		PushBeforeSent(libmodule::twi::TWISlave::Callbacks &next, speedmonitor_t &monitor) : next(next), monitor(monitor) {}
+	private:
+		libmodule::twi::TWISlave::Callbacks &next;
+		speedmonitor_t &monitor;
+	};
+
+	/* A sample is pushed to the stream FIFO after the master has read Count, but before the slave pops what was read.
+	 * The slave must only pop the samples the master was told about, so every sample arrives exactly once and in order.
+	 */
+	bool push_between_send_and_sent()
+	{
+		sim::Bus bus;
+		sim::Master twimaster(bus);
+		sim::Slave twislave;
+		bus.attach(twislave);
+
+		speedmonitor_t speedmonitor;
+		HookedSpeedMonitorManager slave(twislave);
+		slave.register_speedMonitor(0, &speedmonitor);
+		slave.set_twiaddr(config::addr);
+		slave.set_operational(true);
+		PushBeforeSent hook(slave.twi_callbacks(), speedmonitor);
+		hook.m_total = 100;
+
+		rt::module::SpeedMonitorManager<uint16_t> master(twimaster, config::addr, 1000 / 30, true);
+
+		uint16_t expected = 0;
+		uint8_t lastpos = 0;
+		while(bus.now() < config::timeout_ns && expected < hook.m_total) {
+			slave.update();
+			//SlaveBufferManager::update sets the callbacks each time
+			twislave.set_callbacks(&hook);
+			master.Master::update();
+			master.update();
+			bus.run(config::loop_ns);
+			if(!master.m_ready || master.m_samplecount == 0)
+				continue;
+			if(!hook.m_armed) {
+				hook.m_armed = true;
+				lastpos = master.get_sample_pos(0);
+			}
+			//Check each sample the master has received since the last pass
+			uint8_t const pos = master.get_sample_pos(0);
+			while(lastpos != pos) {
+				if(++lastpos >= master.m_samplecount)
+					lastpos = 0;
+				if(master.get_sample(0, lastpos) != expected++)
+					return false;
+			}
+		}
+		return expected == hook.m_total && master.m_streamLost == 0;
+	}
+
+	struct Scenario {
+		char const *name;
+		bool (*fn)();
+	};
+	Scenario const scenarios[] = {
+		{"write inside merged read", write_inside_merged_read},
+		{"queued write inside other pass read", queued_write_inside_other_pass_read},
+		{"push between send and sent", push_between_send_and_sent},
+	};
+}
+
+int scenario::run(std::ostream &out)
+{
+	int rtrn = 0;
+	for(auto const &entry : scenarios) {
+		bool const pass = entry.fn();
+		out << (pass ? "PASS " : "FAIL ") << entry.name << '\n';
+		if(!pass)
+			rtrn = 1;
+	}
+	return rtrn;
+}
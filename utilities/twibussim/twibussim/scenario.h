@@ -0,0 +1,18 @@
+//Created: 20/10/2019 10:05:12 AM
+
+/** \file
+ \brief Protocol scenarios that are checked on the simulated bus.
+ \details Each scenario sets up a situation that has caused (or could cause) data to be lost between a master and a module, and checks the result. Used as a regression test for the master runtime and the libmodule slave code.
+ \date Created 2019-10-20
+ \author Teddy.Hut
+ */
+
+#pragma once
+
+#include <iosfwd>
+
+///Primary namespace for scenario.h.
+namespace scenario {
+	///Runs every scenario and prints PASS or FAIL for each to \a out. Returns 0 if all passed, 1 otherwise.
+	int run(std::ostream &out);
+}
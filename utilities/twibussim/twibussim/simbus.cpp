@@ -0,0 +1,410 @@
+//Created: 19/10/2019 1:13:20 PM
+
+/** \file
+ \brief Source file for simbus.h.
+ \date Created 2019-10-19
+ \author Teddy.Hut
+ */
+
+#include "simbus.h"
+
+#include <timerhardware.h>
+
+bool sim::Slave::communicating() const
+{
+	return pm_state == State::Transaction;
+}
+
+bool sim::Slave::attention() const
+{
+	return pm_result != Result::Wait;
+}
+
+libmodule::twi::TWISlave::Result sim::Slave::result() const
+{
+	return pm_result;
+}
+
+void sim::Slave::reset()
+{
+	pm_result = Result::Wait;
+}
+
+libmodule::twi::TWISlave::TransactionInfo sim::Slave::lastTransaction()
+{
+	if(pm_result == Result::Received || pm_result == Result::Sent)
+		pm_result = Result::Wait;
+	return pm_previoustransaction;
+}
+
+void sim::Slave::set_callbacks(Callbacks *const callbacks)
+{
+	pm_callbacks = callbacks;
+}
+
+void sim::Slave::set_address(uint8_t const addr)
+{
+	pm_address = addr;
+}
+
+void sim::Slave::set_generalcall(bool const enable)
+{
+	pm_generalcall = enable;
+}
+
+void sim::Slave::set_recvBuffer(uint8_t *const buf, uint16_t const len)
+{
+	pm_recvbuf.buf = buf;
+	pm_recvbuf.len = len;
+}
+
+void sim::Slave::set_sendBuffer(uint8_t const *const buf, uint16_t const len)
+{
+	pm_sendbuf.buf = buf;
+	pm_sendbuf.len = len;
+}
+
+bool sim::Slave::address_match(uint8_t const addr, bool const read) const
+{
+	//Same as TWISlave0::enableCheck, the slave is only enabled when both buffers are set
+	return m_present && (addr == pm_address || (addr == 0x00 && pm_generalcall && !read)) &&
+	       pm_sendbuf.buf != nullptr && pm_sendbuf.len > 0 && pm_recvbuf.buf != nullptr && pm_recvbuf.len > 0;
+}
+
+void sim::Slave::begin(bool const read)
+{
+	end();
+	pm_state = State::Transaction;
+	pm_bufpos = 0;
+	//A master read is the slave sending
+	if(read) {
+		pm_currenttransaction.dir = TransactionInfo::Type::Send;
+		pm_currenttransaction.buf = pm_sendbuf.buf;
+	}
+	else {
+		pm_currenttransaction.dir = TransactionInfo::Type::Receive;
+		pm_currenttransaction.buf = pm_recvbuf.buf;
+	}
+}
+
+bool sim::Slave::receive(uint8_t const data)
+{
+	//NACK is sent for the past the end byte
+	if(pm_bufpos >= pm_recvbuf.len) {
+		pm_result = Result::NACKSent;
+		return false;
+	}
+	pm_recvbuf.buf[pm_bufpos++] = data;
+	return true;
+}
+
+uint8_t sim::Slave::send()
+{
+	//Past the end, send 0
+	if(pm_bufpos >= pm_sendbuf.len)
+		return 0;
+	return pm_sendbuf.buf[pm_bufpos++];
+}
+
+void sim::Slave::end()
+{
+	if(pm_state != State::Transaction)
+		return;
+	pm_state = State::Idle;
+	pm_previoustransaction = pm_currenttransaction;
+	pm_previoustransaction.len = pm_bufpos;
+	pm_result = (pm_previoustransaction.dir == TransactionInfo::Type::Send ? Result::Sent : Result::Received);
+	if(pm_callbacks != nullptr) {
+		if(pm_previoustransaction.dir == TransactionInfo::Type::Send)
+			pm_callbacks->sent(pm_previoustransaction.buf, pm_previoustransaction.len);
+		else
+			pm_callbacks->received(pm_previoustransaction.buf, pm_previoustransaction.len);
+	}
+}
+
+void sim::Slave::error()
+{
+	pm_state = State::Idle;
+	pm_result = Result::Error;
+	pm_currenttransaction.buf = nullptr;
+	pm_currenttransaction.len = 0;
+}
+
+bool sim::Master::attention() const
+{
+	return pm_result != Result::Wait;
+}
+
+hw::TWIMaster::Result sim::Master::result() const
+{
+	return pm_result;
+}
+
+bool sim::Master::ready() const
+{
+	return !pm_busy;
+}
+
+bool sim::Master::communicating() const
+{
+	return pm_busy;
+}
+
+void sim::Master::writeBuffer(uint8_t const addr, uint8_t const buf[], uint16_t const len /*= 0*/)
+{
+	execute({addr, false, 0, true, buf, len, false, nullptr, 0}, CallbackType::WriteBuffer_Complete);
+}
+
+void sim::Master::readBuffer(uint8_t const addr, uint8_t buf[], uint16_t const len /*= 0*/)
+{
+	execute({addr, false, 0, false, nullptr, 0, true, buf, len}, CallbackType::ReadBuffer_Complete);
+}
+
+void sim::Master::writeReadBuffer(uint8_t const addr, uint8_t const writebuf[], uint16_t const writelen, uint8_t readbuf[], uint16_t const readlen /*= 0*/)
+{
+	execute({addr, false, 0, true, writebuf, writelen, true, readbuf, readlen}, CallbackType::WriteReadBuffer_Complete);
+}
+
+void sim::Master::writeToAddress(uint8_t const addr, uint8_t const regaddr, uint8_t const buf[], uint16_t const len /*= 0*/)
+{
+	execute({addr, true, regaddr, true, buf, len, false, nullptr, 0}, CallbackType::WriteToAddress_Complete);
+}
+
+void sim::Master::readFromAddress(uint8_t const addr, uint8_t const regaddr, uint8_t buf[], uint16_t const len /*= 0*/)
+{
+	execute({addr, true, regaddr, false, nullptr, 0, true, buf, len}, CallbackType::ReadFromAddress_Complete);
+}
+
+void sim::Master::checkForAddress(uint8_t const addr)
+{
+	execute({addr, false, 0, false, nullptr, 0, false, nullptr, 0}, CallbackType::CheckForAddress_Complete);
+}
+
+void sim::Master::registerCallback(Callback_t const callback)
+{
+	pm_callback = callback;
+}
+
+sim::Master::Master(Bus &bus) : bus(bus)
+{
+	bus.pm_master = this;
+}
+
+void sim::Master::execute(Request const &request, CallbackType const type)
+{
+	bus.pm_transaction_ns = 0;
+	pm_pendingresult = transfer(request);
+	pm_callbacktype = type;
+	pm_result = Result::Wait;
+	pm_busy = true;
+	pm_completetime = bus.pm_time + bus.pm_transaction_ns;
+	bus.m_statistics.busy_ns += bus.pm_transaction_ns;
+}
+
+hw::TWIMaster::Result sim::Master::transfer(Request const &request)
+{
+	Result result;
+	//checkForAddress is a write with no data
+	if(request.write || request.regaddr_valid || !request.read) {
+		result = bus.start(request.addr, false);
+		if(result != Result::Success)
+			return result;
+		if(request.regaddr_valid) {
+			result = bus.write(request.regaddr);
+			if(result != Result::Success)
+				return result;
+		}
+		if(request.write) {
+			for(uint16_t pos = 0; request.writelen > 0 ? pos < request.writelen : (pos == 0 || request.writebuf[pos - 1] != 0); pos++) {
+				result = bus.write(request.writebuf[pos]);
+				if(result != Result::Success)
+					return result;
+			}
+		}
+	}
+	if(request.read) {
+		//Repeated START if there was a write phase
+		result = bus.start(request.addr, true);
+		if(result != Result::Success)
+			return result;
+		for(uint16_t pos = 0; ; pos++) {
+			//Master NACKs the last byte
+			bool const last = request.readlen > 0 && pos + 1 >= request.readlen;
+			uint8_t data;
+			result = bus.read(data, !last);
+			if(result != Result::Success)
+				return result;
+			request.readbuf[pos] = data;
+			if(last || (request.readlen == 0 && data == 0))
+				break;
+		}
+	}
+	bus.stop();
+	return Result::Success;
+}
+
+void sim::Master::complete()
+{
+	pm_busy = false;
+	pm_result = pm_pendingresult;
+	if(pm_callback != nullptr)
+		pm_callback(pm_callbacktype);
+}
+
+void sim::Bus::attach(Slave &slave)
+{
+	pm_slaves.push_back(&slave);
+}
+
+void sim::Bus::run(uint64_t const ns)
+{
+	uint64_t const target = pm_time + ns;
+	while(true) {
+		//Move to whichever happens first: the end, a timer tick, or the master operation finishing
+		uint64_t next = target;
+		if(pm_nexttick < next)
+			next = pm_nexttick;
+		if(pm_master != nullptr && pm_master->pm_busy && pm_master->pm_completetime < next)
+			next = pm_master->pm_completetime;
+		pm_time = next;
+		if(pm_master != nullptr && pm_master->pm_busy && pm_master->pm_completetime <= pm_time)
+			pm_master->complete();
+		if(pm_nexttick <= pm_time) {
+			pm_nexttick += 1000000;
+			libmodule::time::isr_rtc();
+		}
+		if(pm_time >= target)
+			break;
+	}
+}
+
+uint64_t sim::Bus::now() const
+{
+	return pm_time;
+}
+
+uint32_t sim::Bus::bit_ns() const
+{
+	return 1000000000ul / m_config.frequency;
+}
+
+sim::Bus::Bus(BusConfig const &config /*= BusConfig()*/) : m_config(config), pm_nexttick(1000000), pm_random(config.seed) {}
+
+sim::Bus::Result sim::Bus::start(uint8_t const addr, bool const read)
+{
+	bool const repeated = pm_started;
+	//A repeated START finishes the slave transaction
+	if(repeated) {
+		for(auto slave : pm_selected)
+			slave->end();
+	}
+	else
+		m_statistics.transactions++;
+	m_statistics.starts++;
+	pm_started = true;
+	elapse(1);
+
+	m_statistics.address_bytes++;
+	//Only the first address byte is arbitrated (another master could start at the same time)
+	if(!repeated && fault(m_config.p_arbitration)) {
+		elapse(9);
+		m_statistics.arbitration_lost++;
+		pm_started = false;
+		pm_selected.clear();
+		return Result::ArbitrationLost;
+	}
+	pm_selected.clear();
+	for(auto slave : pm_slaves) {
+		if(slave->address_match(addr, read)) {
+			pm_selected.push_back(slave);
+			//Only a general call can select more than one slave
+			if(addr != 0x00)
+				break;
+		}
+	}
+	elapse(9);
+	if(fault(m_config.p_buserror)) {
+		abort();
+		return Result::Error;
+	}
+	if(pm_selected.empty()) {
+		m_statistics.nacks++;
+		stop();
+		return Result::NoResponse;
+	}
+	for(auto slave : pm_selected)
+		slave->begin(read);
+	return Result::Success;
+}
+
+sim::Bus::Result sim::Bus::write(uint8_t const data)
+{
+	m_statistics.data_bytes++;
+	elapse(9);
+	if(fault(m_config.p_buserror)) {
+		abort();
+		return Result::Error;
+	}
+	//Every selected slave receives the byte, the master sees an ACK if any of them ACKed
+	bool ack = false;
+	for(auto slave : pm_selected)
+		ack |= slave->receive(data);
+	if(fault(m_config.p_nack) || !ack) {
+		m_statistics.nacks++;
+		stop();
+		return Result::NACKReceived;
+	}
+	return Result::Success;
+}
+
+sim::Bus::Result sim::Bus::read(uint8_t &data, bool const ack)
+{
+	m_statistics.data_bytes++;
+	data = pm_selected.front()->send();
+	elapse(9);
+	if(fault(m_config.p_buserror)) {
+		abort();
+		return Result::Error;
+	}
+	return Result::Success;
+}
+
+void sim::Bus::stop()
+{
+	elapse(1);
+	for(auto slave : pm_selected)
+		slave->end();
+	pm_selected.clear();
+	pm_started = false;
+}
+
+void sim::Bus::abort()
+{
+	m_statistics.bus_errors++;
+	for(auto slave : pm_selected)
+		slave->error();
+	pm_selected.clear();
+	pm_started = false;
+}
+
+void sim::Bus::elapse(uint8_t const bits)
+{
+	pm_transaction_ns += static_cast<uint64_t>(bits) * bit_ns();
+	//Slaves stretch the clock after each byte while their interrupt runs (SCL is released once the slowest is done)
+	uint32_t stretch_ns = 0;
+	if(bits == 9) {
+		for(auto slave : pm_selected) {
+			if(slave->m_stretch_ns > stretch_ns)
+				stretch_ns = slave->m_stretch_ns;
+		}
+	}
+	pm_transaction_ns += stretch_ns;
+	m_statistics.stretch_ns += stretch_ns;
+}
+
+bool sim::Bus::fault(double const probability)
+{
+	if(probability <= 0)
+		return false;
+	return std::uniform_real_distribution<double>(0, 1)(pm_random) < probability;
+}
@@ -0,0 +1,208 @@
+//Created: 19/10/2019 1:12:48 PM
+
+/** \file
+ \brief Simulated TWI (I2C) bus for running master and slave module code on a host.
+ \details sim::Master implements hw::TWIMaster (as used by TestMaster) and sim::Slave implements libmodule::twi::TWISlave (as used by the modules), so the real MasterBufferManager and SlaveBufferManager code can talk to each other without hardware.
+ \n Each operation is carried out byte by byte when the master starts it (slave callbacks are made straight away, like the interrupt would), but the result is only given to the master once the simulated bus time for the operation has passed.
+ \date Created 2019-10-19
+ \author Teddy.Hut
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <random>
+#include <vector>
+
+#include <libmodule/twislave.h>
+#include <hardware/twi.h>
+
+///Primary namespace for simbus.h.
+namespace sim {
+	class Bus;
+
+	///Timing and fault settings for Bus.
+	struct BusConfig {
+		///SCL frequency in Hz.
+		uint32_t frequency = 100000;
+		///Probability (0 to 1) that a slave NACKs a data byte written to it.
+		double p_nack = 0;
+		///Probability (0 to 1) that arbitration is lost (to another master) on the address byte of a transaction.
+		double p_arbitration = 0;
+		///Probability (0 to 1) that any byte has a bus error (e.g. a glitch on SDA).
+		double p_buserror = 0;
+		///Seed for the fault random number generator (so runs are repeatable).
+		uint32_t seed = 1;
+	};
+
+	///What the bus has been used for. Byte counts include the ACK/NACK bit.
+	struct BusStatistics {
+		///Time that the bus was not idle (ns).
+		uint64_t busy_ns = 0;
+		///Time that slaves held SCL low (ns), included in #busy_ns.
+		uint64_t stretch_ns = 0;
+		///Number of START to STOP transactions.
+		uint32_t transactions = 0;
+		///Number of START and repeated START conditions.
+		uint32_t starts = 0;
+		uint32_t address_bytes = 0;
+		uint32_t data_bytes = 0;
+		uint32_t nacks = 0;
+		uint32_t arbitration_lost = 0;
+		uint32_t bus_errors = 0;
+	};
+
+	/** \brief A simulated slave device.
+	 \details Behaves like hw::TWISlave0 (from Horn): the transaction is finished, and the callback made, when a STOP or repeated START is seen.
+	 \n The slave only acknowledges its address when both a send and receive buffer have been set.
+	 \n With general call enabled, writes to address 0x00 are also received (by every such slave on the bus at once).
+	 */
+	class Slave : public libmodule::twi::TWISlave {
+		friend Bus;
+	public:
+		bool communicating() const override;
+		bool attention() const override;
+		Result result() const override;
+		void reset() override;
+		TransactionInfo lastTransaction() override;
+		void set_callbacks(Callbacks *const callbacks) override;
+		void set_address(uint8_t const addr) override;
+		void set_generalcall(bool const enable) override;
+		void set_recvBuffer(uint8_t *const buf, uint16_t const len) override;
+		void set_sendBuffer(uint8_t const *const buf, uint16_t const len) override;
+
+		///Time that SCL is held low after every byte (ns), models the interrupt latency of the slave.
+		uint32_t m_stretch_ns = 0;
+		///When false the slave does not respond to its address (e.g. unplugged).
+		bool m_present = true;
+	private:
+		bool address_match(uint8_t const addr, bool const read) const;
+		//Start of a transaction (after the address was ACKed)
+		void begin(bool const read);
+		//Master writing, returns ACK
+		bool receive(uint8_t const data);
+		//Master reading
+		uint8_t send();
+		//STOP or repeated START, finishes the transaction
+		void end();
+		//Bus error, transaction discarded
+		void error();
+
+		enum class State : uint8_t {
+			Idle,
+			Transaction,
+		} pm_state = State::Idle;
+		Result pm_result = Result::Wait;
+		TransactionInfo pm_currenttransaction;
+		TransactionInfo pm_previoustransaction;
+		Callbacks *pm_callbacks = nullptr;
+		uint8_t pm_address = 0;
+		bool pm_generalcall = false;
+		uint16_t pm_bufpos = 0;
+		struct {
+			uint8_t *buf = nullptr;
+			uint16_t len = 0;
+		} pm_recvbuf;
+		struct {
+			uint8_t const *buf = nullptr;
+			uint16_t len = 0;
+		} pm_sendbuf;
+	};
+
+	/** \brief A simulated master (the only master on the bus, arbitration loss is modelled as a random fault).
+	 \details Results are the same as hw::TWIMaster0, e.g. NoResponse when the address is NACKed and NACKReceived when data is NACKed.
+	 */
+	class Master : public hw::TWIMaster {
+		friend Bus;
+	public:
+		bool attention() const override;
+		Result result() const override;
+		bool ready() const override;
+		bool communicating() const override;
+
+		void writeBuffer(uint8_t const addr, uint8_t const buf[], uint16_t const len = 0) override;
+		void readBuffer(uint8_t const addr, uint8_t buf[], uint16_t const len = 0) override;
+
+		void writeReadBuffer(uint8_t const addr, uint8_t const writebuf[], uint16_t const writelen, uint8_t readbuf[], uint16_t const readlen = 0) override;
+
+		void writeToAddress(uint8_t const addr, uint8_t const regaddr, uint8_t const buf[], uint16_t const len = 0) override;
+		void readFromAddress(uint8_t const addr, uint8_t const regaddr, uint8_t buf[], uint16_t const len = 0) override;
+
+		void checkForAddress(uint8_t const addr) override;
+
+		void registerCallback(Callback_t const callback) override;
+
+		Master(Bus &bus);
+	private:
+		struct Request {
+			uint8_t addr;
+			//Register address is written first if true
+			bool regaddr_valid;
+			uint8_t regaddr;
+			//Write phase (0 len means until '\0' inclusive)
+			bool write;
+			uint8_t const *writebuf;
+			uint16_t writelen;
+			//Read phase, after a repeated START if there was a write phase (0 len means until '\0')
+			bool read;
+			uint8_t *readbuf;
+			uint16_t readlen;
+		};
+		//Carries out the request on the bus and schedules the result
+		void execute(Request const &request, CallbackType const type);
+		Result transfer(Request const &request);
+		//Called by the bus when the simulated time for the operation has passed
+		void complete();
+
+		Bus &bus;
+		Result pm_result = Result::Success;
+		Result pm_pendingresult = Result::Success;
+		CallbackType pm_callbacktype = CallbackType::WriteBuffer_Complete;
+		bool pm_busy = false;
+		uint64_t pm_completetime = 0;
+		Callback_t pm_callback = nullptr;
+	};
+
+	/** \brief The bus, which connects one Master to any number of Slave objects and keeps simulated time.
+	 \details Call run() from the host main loop to move simulated time forward. libmodule 1kHz timers are ticked every simulated millisecond.
+	 */
+	class Bus {
+		friend Master;
+	public:
+		void attach(Slave &slave);
+		///Moves simulated time forward by \a ns, completing master operations and ticking timers as that time passes.
+		void run(uint64_t const ns);
+		///Simulated time (ns).
+		uint64_t now() const;
+		///Length of one SCL period (ns).
+		uint32_t bit_ns() const;
+
+		BusConfig m_config;
+		BusStatistics m_statistics;
+
+		Bus(BusConfig const &config = BusConfig());
+	private:
+		using Result = hw::TWIMaster::Result;
+		//Bus conditions used by Master. Time is added to pm_transaction_ns.
+		//START (or repeated START) followed by the address byte
+		Result start(uint8_t const addr, bool const read);
+		Result write(uint8_t const data);
+		Result read(uint8_t &data, bool const ack);
+		void stop();
+		//Bus error: slaves drop the transaction, no STOP is sent
+		void abort();
+		//Adds bits of bus time (and clock stretching from the selected slave)
+		void elapse(uint8_t const bits);
+		bool fault(double const probability);
+
+		std::vector<Slave *> pm_slaves;
+		Master *pm_master = nullptr;
+		//Slaves that acknowledged the address (more than one for a general call)
+		std::vector<Slave *> pm_selected;
+		bool pm_started = false;
+		uint64_t pm_time = 0;
+		uint64_t pm_nexttick;
+		uint64_t pm_transaction_ns = 0;
+		std::mt19937 pm_random;
+	};
+}
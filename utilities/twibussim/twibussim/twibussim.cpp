@@ -0,0 +1,165 @@
+// twibussim.cpp : Defines the entry point for the console application.
+//
+
+//Runs the TestMaster master runtime against the libmodule slave code on a simulated TWI bus, and prints how the bus was used
+//Usage: twibussim [frequency Hz] [duration ms] [p_nack] [p_arbitration] [p_buserror]
+//       twibussim report [baseline file] [--write]
+//         Prints the protocol efficiency of each module type (see report.h). With a baseline file, exits with 1 if any result is worse than the baseline.
+//         With --write, the baseline file is updated instead (commit it along with intended protocol changes).
+//       twibussim check
+//         Runs the protocol scenarios (see scenario.h). Exits with 1 if any fail.
+//Build (from this directory, as a single command):
+//  g++ -std=gnu++14 -O2 -funsigned-char -Ihost -I../../../libmodule/src -I../../../TestMaster
+//      *.cpp host/*.cpp ../../../TestMaster/runtime/*.cpp
+//      ../../../libmodule/src/libmodule/{utility,twislave,module,metadata,userio}.cpp -o twibussim
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+#include <libmodule/module.h>
+#include <runtime/module.h>
+#include <runtime/scheduler.h>
+
+#include "simbus.h"
+#include "report.h"
+#include "scenario.h"
+
+void libmodule::hw::panic()
+{
+	std::cerr << "panic() called\n";
+	std::exit(1);
+}
+
+namespace config {
+	//Time taken by one pass of the main loops (ns)
+	constexpr uint64_t loop_ns = 50000;
+	constexpr uint8_t addr_horn = 0x02;
+	constexpr uint8_t addr_speedmonitor = 0x03;
+	constexpr uint8_t addr_motorcontroller = 0x04;
+	//Time the module interrupt takes to respond to each byte (ns)
+	constexpr uint32_t slave_stretch_ns = 5000;
+	//Modules are powered up this long before the master (so their clocks are offset from the master clock)
+	constexpr uint32_t master_start_ms = 37;
+}
+
+using speedmonitor_t = libmodule::module::SpeedMonitor<8, uint16_t, true>;
+
+int main(int argc, char *argv[])
+{
+	if(argc > 1 && std::strcmp(argv[1], "report") == 0)
+		return report::run(std::cout, argc > 2 ? argv[2] : nullptr, argc > 3 && std::strcmp(argv[3], "--write") == 0);
+	if(argc > 1 && std::strcmp(argv[1], "check") == 0)
+		return scenario::run(std::cout);
+
+	sim::BusConfig busconfig;
+	uint32_t duration_ms = 5000;
+	if(argc > 1) busconfig.frequency = std::strtoul(argv[1], nullptr, 10);
+	if(argc > 2) duration_ms = std::strtoul(argv[2], nullptr, 10);
+	if(argc > 3) busconfig.p_nack = std::strtod(argv[3], nullptr);
+	if(argc > 4) busconfig.p_arbitration = std::strtod(argv[4], nullptr);
+	if(argc > 5) busconfig.p_buserror = std::strtod(argv[5], nullptr);
+
+	sim::Bus bus(busconfig);
+	sim::Master twimaster(bus);
+
+	//---Modules---
+	sim::Slave twislave_horn, twislave_speedmonitor, twislave_motorcontroller;
+	for(auto slave : {&twislave_horn, &twislave_speedmonitor, &twislave_motorcontroller}) {
+		slave->m_stretch_ns = config::slave_stretch_ns;
+		bus.attach(*slave);
+	}
+
+	libmodule::module::Horn horn(twislave_horn);
+	horn.set_twiaddr(config::addr_horn);
+	horn.set_signature(0x10);
+	horn.set_name("Horn");
+	horn.set_operational(true);
+	horn.set_timesync(true);
+
+	libmodule::module::SpeedMonitorManager<speedmonitor_t, 2> speedmonitormanager(twislave_speedmonitor);
+	speedmonitor_t speedmonitor[2];
+	speedmonitormanager.set_twiaddr(config::addr_speedmonitor);
+	speedmonitormanager.set_signature(0x28);
+	speedmonitormanager.set_name("SpdMon");
+	speedmonitormanager.set_operational(true);
+	speedmonitormanager.set_timesync(true);
+	for(uint8_t i = 0; i < 2; i++) {
+		speedmonitormanager.register_speedMonitor(i, &speedmonitor[i]);
+		speedmonitor[i].set_rps_constant(100);
+	}
+
+	libmodule::module::MotorController motorcontroller(twislave_motorcontroller);
+	motorcontroller.set_twiaddr(config::addr_motorcontroller);
+	motorcontroller.set_signature(0x38);
+	motorcontroller.set_name("MotorCtl");
+	motorcontroller.set_operational(true);
+	motorcontroller.set_timesync(true);
+
+	bus.run(static_cast<uint64_t>(config::master_start_ms) * 1000000);
+
+	//---Master---
+	rt::twi::BusScheduler scheduler(twimaster);
+	rt::twi::BusChannel channel_horn(scheduler), channel_speedmonitor(scheduler), channel_motorcontroller(scheduler), channel_timesync(scheduler);
+	rt::module::TimeSync timesync(channel_timesync);
+	rt::module::Horn master_horn(channel_horn, config::addr_horn);
+	rt::module::SpeedMonitorManager<uint16_t> master_speedmonitor(channel_speedmonitor, config::addr_speedmonitor);
+	rt::module::MotorController master_motorcontroller(channel_motorcontroller, config::addr_motorcontroller);
+
+	libmodule::Timer1k sampletimer;
+	sampletimer.finished = true;
+	uint16_t measured_current = 0;
+	while(bus.now() < static_cast<uint64_t>(duration_ms) * 1000000) {
+		//Module main loops
+		horn.update();
+		speedmonitormanager.update();
+		motorcontroller.Slave::update();
+		motorcontroller.update();
+		if(sampletimer) {
+			sampletimer = 10;
+			sampletimer.start();
+			for(auto &monitor : speedmonitor)
+				monitor.push_sample(1000);
+			motorcontroller.set_measured_current(measured_current++);
+		}
+		//Master main loop
+		master_horn.update();
+		master_speedmonitor.Master::update();
+		master_speedmonitor.update();
+		master_motorcontroller.update();
+		timesync.update();
+		scheduler.update();
+
+		bus.run(config::loop_ns);
+	}
+
+	//---Report---
+	auto const &statistics = bus.m_statistics;
+	uint64_t const total_ns = bus.now();
+	std::cout << "Frequency: " << busconfig.frequency << "Hz, simulated " << duration_ms << "ms\n";
+	std::cout << "Bus busy: " << statistics.busy_ns / 1000 << "us (" << (100.0 * statistics.busy_ns / total_ns) << "%), clock stretching " << statistics.stretch_ns / 1000 << "us\n";
+	std::cout << "Transactions: " << statistics.transactions << ", STARTs: " << statistics.starts << '\n';
+	std::cout << "Address bytes: " << statistics.address_bytes << ", data bytes: " << statistics.data_bytes << '\n';
+	std::cout << "NACKs: " << statistics.nacks << ", arbitration lost: " << statistics.arbitration_lost << ", bus errors: " << statistics.bus_errors << '\n';
+	struct {
+		char const *name;
+		rt::module::Master const *master;
+		rt::twi::BusChannel const *channel;
+	} const masters[] = {
+		{"Horn", &master_horn, &channel_horn},
+		{"SpeedMonitor", &master_speedmonitor, &channel_speedmonitor},
+		{"MotorController", &master_motorcontroller, &channel_motorcontroller},
+	};
+	for(auto const &entry : masters) {
+		auto const &manager = entry.master->buffermanager;
+		std::cout << entry.name << ": " << static_cast<unsigned>(manager.m_lastCycleMetrics.transactions) << " transactions/" << manager.m_lastCycleMetrics.bytes << " bytes per cycle, "
+		          << manager.m_deadlineMisses << " reg deadline misses, max bus wait " << entry.channel->m_maxWait << "ms, "
+		          << static_cast<unsigned>(manager.m_consecutiveCycleErrors) << " consecutive cycle errors\n";
+	}
+	std::cout << "MotorController measured current (master copy): " << master_motorcontroller.get_measured_current() << ", module: " << measured_current - 1 << '\n';
+	std::cout << "Time sync: master " << timesync.get_time() << "ms, Horn " << horn.get_time() << "ms, SpeedMonitor " << speedmonitormanager.get_time() << "ms, MotorController " << motorcontroller.get_time()
+	          << "ms, " << timesync.m_failures << " failed broadcasts\n";
+	uint8_t const samplepos = master_speedmonitor.get_sample_pos(0);
+	std::cout << "Latest SpeedMonitor sample (master copy) taken at " << master_speedmonitor.get_sample_time(0, samplepos) << "ms, previous at " << master_speedmonitor.get_sample_time(0, (samplepos + speedmonitor_t::sample_count - 1) % speedmonitor_t::sample_count) << "ms\n";
+	return 0;
+}